@@ -2,12 +2,47 @@
 
 void AABB_Set(AABB *aabb, float minX, float minY, float maxX, float maxY)
 {
-    Vector2_Set(&aabb[0], minX, minY);
-    Vector2_Set(&aabb[1], maxX, maxY);
+    Vector2_Set(&(*aabb)[0], minX, minY);
+    Vector2_Set(&(*aabb)[1], maxX, maxY);
 }
 
 void AABB_Setv(AABB *aabb, Vector2 min, Vector2 max)
 {
-    Vector2_Setv(&aabb[0], min);
-    Vector2_Setv(&aabb[1], max);
+    Vector2_Setv(&(*aabb)[0], min);
+    Vector2_Setv(&(*aabb)[1], max);
+}
+
+void AABB_Combine(AABB *result, AABB a, AABB b)
+{
+    AABB_Set(result, 
+            (a[0][0] < b[0][0]) ? a[0][0] : b[0][0],
+            (a[0][1] < b[0][1]) ? a[0][1] : b[0][1],
+            (a[1][0] > b[1][0]) ? a[1][0] : b[1][0],
+            (a[1][1] > b[1][1]) ? a[1][1] : b[1][1]);
+}
+
+bool AABB_Overlap(AABB a, AABB b)
+{
+    if (a[1][0] < b[0][0] || b[1][0] < a[0][0])
+    {
+        return false;
+    }
+
+    if (a[1][1] < b[0][1] || b[1][1] < a[0][1])
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool AABB_Contains(AABB outer, AABB inner)
+{
+    return (outer[0][0] <= inner[0][0] && outer[0][1] <= inner[0][1] &&
+            outer[1][0] >= inner[1][0] && outer[1][1] >= inner[1][1]);
+}
+
+float AABB_Perimeter(AABB aabb)
+{
+    return 2.0f * ((aabb[1][0] - aabb[0][0]) + (aabb[1][1] - aabb[0][1]));
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include <stdlib.h>
+#include "alloc.h"
+
+/* bumped from the narrow-phase workers too */
+static Uint64 allocationCount = 0;
+
+void *Alloc_Malloc(size_t size)
+{
+    __atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void *Alloc_Realloc(void *memory, size_t size)
+{
+    __atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+    return realloc(memory, size);
+}
+
+void Alloc_Free(void *memory)
+{
+    free(memory);
+}
+
+Uint64 Alloc_GetCount(void)
+{
+    return __atomic_load_n(&allocationCount, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,17 @@
+#ifndef _ALLOC_H_
+#define _ALLOC_H_
+
+#include "types.h"
+#include <stddef.h>
+
+/*
+    Every heap allocation of the physics code goes through here so the number of
+    malloc/realloc calls can be read back, a warm world should not move it.
+*/
+void *Alloc_Malloc(size_t size);
+void *Alloc_Realloc(void *memory, size_t size);
+void Alloc_Free(void *memory);
+
+Uint64 Alloc_GetCount(void);
+
+#endif
@@ -0,0 +1,650 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "world.h"
+#include "body.h"
+#include "collision.h"
+#include "worldfile.h"
+#include "replay.h"
+
+typedef struct BenchScene               BenchScene;
+typedef struct BenchResult              BenchResult;
+
+#define BENCH_DEFAULT_STEPS     120
+#define BENCH_ITERATIONS        20
+#define BENCH_TIME_STEP         (1.0f / 60.0f)
+#define BENCH_SEED              0x9e3779b9u
+
+#define BENCH_SAT_POLYGONS      4096
+#define BENCH_SAT_ROUNDS        200
+
+#define BENCH_SETTLE_STEPS      1200
+
+struct BenchScene
+{
+    const char *name;
+    void (*build)(World *world);
+};
+
+struct BenchResult
+{
+    int bodies;
+    int steps;
+    double seconds;
+    double setupSeconds;
+    long long pairTests;
+    long long contacts;
+    long long substeps;
+};
+
+/* xorshift32, rand() differs between C libraries and the scenes must not */
+static Uint32 benchState = BENCH_SEED;
+
+static Vector2 benchPolygons[BENCH_SAT_POLYGONS][4];
+static Vector2 benchNormals[BENCH_SAT_POLYGONS][4];
+static Vector2 benchCenters[BENCH_SAT_POLYGONS];
+
+static Uint32 Bench_Random(void)
+{
+    benchState ^= benchState << 13;
+    benchState ^= benchState >> 17;
+    benchState ^= benchState << 5;
+
+    return benchState;
+}
+
+static float Bench_Range(float min, float max)
+{
+    return min + (max - min) * ((Bench_Random() & 0xffffff) / (float)0x1000000);
+}
+
+static double Bench_Seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static void Bench_AddGround(World *world)
+{
+    Body ground;
+    Vector2 position = {512, 551};
+
+    Body_NewBox(&ground, &world->shapes, position, 120.0f, 5.0f, 50.0f, 0.0f, 0.5f, true);
+    World_AddBody(world, &ground);
+}
+
+static void Bench_AddBox(World *world, float x, float y, float width, float height)
+{
+    Body box;
+    Vector2 position = {x, y};
+
+    Body_NewBox(&box, &world->shapes, position, width, height, 50.0f, 0.0f, 0.5f, false);
+    World_AddBody(world, &box);
+}
+
+static void Bench_AddCircle(World *world, float x, float y, float radius)
+{
+    Body circle;
+    Vector2 position = {x, y};
+
+    Body_NewCircle(&circle, &world->shapes, position, radius, 50.0f, 0.0f, 0.5f, false);
+    World_AddBody(world, &circle);
+}
+
+/* hull of SHAPE_MAX_VERTICES points around a circle of radius, jittered in angle and length */
+static void Bench_AddPolygon(World *world, float x, float y, float radius)
+{
+    Body polygon;
+    Vector2 position = {x, y};
+    Vector2 points[SHAPE_MAX_VERTICES];
+
+    for (int i = 0; i < SHAPE_MAX_VERTICES; ++i)
+    {
+        float angle = (i + Bench_Range(-0.3f, 0.3f)) * 2.0f * (float)PI / SHAPE_MAX_VERTICES;
+        float length = radius * Bench_Range(0.8f, 1.0f);
+
+        Vector2_Set(&points[i], cosf(angle) * length, sinf(angle) * length);
+    }
+
+    if (Body_NewPolygon(&polygon, &world->shapes, position, points, SHAPE_MAX_VERTICES, 50.0f, 0.0f, 0.5f, false))
+    {
+        World_AddBody(world, &polygon);
+    }
+}
+
+/* 20 rows of 30px boxes resting on the ground, 210 bodies */
+static void Bench_BuildPyramid(World *world)
+{
+    int rows = 20;
+
+    World_Reserve(world, rows * (rows + 1) / 2 + 1);
+    Bench_AddGround(world);
+
+    for (int row = 0; row < rows; ++row)
+    {
+        int count = rows - row;
+        float x = 512.0f - (count - 1) * 15.5f;
+        float y = 526.0f - 15.5f - row * 31.0f;
+
+        for (int i = 0; i < count; ++i)
+        {
+            Bench_AddBox(world, x + i * 31.0f, y, 3.0f, 3.0f);
+        }
+    }
+}
+
+/* 10k circles in a 100 wide column falling onto the ground */
+static void Bench_BuildRain(World *world)
+{
+    int count = 10000;
+    int columns = 100;
+
+    World_Reserve(world, count + 1);
+    Bench_AddGround(world);
+
+    for (int i = 0; i < count; ++i)
+    {
+        float x = 512.0f - (columns / 2) * 13.0f + (i % columns) * 13.0f;
+        float y = 500.0f - (i / columns) * 13.0f;
+
+        Bench_AddCircle(world, x + Bench_Range(-0.5f, 0.5f), y, 1.0f);
+    }
+}
+
+/* 2000 random boxes and circles dropped on top of each other */
+static void Bench_BuildPile(World *world)
+{
+    int count = 2000;
+
+    World_Reserve(world, count + 1);
+    Bench_AddGround(world);
+
+    for (int i = 0; i < count; ++i)
+    {
+        float x = Bench_Range(100.0f, 924.0f);
+        float y = Bench_Range(-1500.0f, 480.0f);
+
+        if (Bench_Random() % 2 == 0)
+        {
+            Bench_AddBox(world, x, y, (float)(Bench_Random() % 3 + 2), (float)(Bench_Random() % 3 + 2));
+        }
+        else
+        {
+            Bench_AddCircle(world, x, y, (float)(Bench_Random() % 3 + 1));
+        }
+    }
+}
+
+/* 2000 random polygons of up to 8 sides and circles dropped on top of each other */
+static void Bench_BuildHulls(World *world)
+{
+    int count = 2000;
+
+    World_Reserve(world, count + 1);
+    Bench_AddGround(world);
+
+    for (int i = 0; i < count; ++i)
+    {
+        float x = Bench_Range(100.0f, 924.0f);
+        float y = Bench_Range(-1500.0f, 480.0f);
+
+        if (Bench_Random() % 4 != 0)
+        {
+            Bench_AddPolygon(world, x, y, (float)(Bench_Random() % 2 + 2));
+        }
+        else
+        {
+            Bench_AddCircle(world, x, y, (float)(Bench_Random() % 3 + 1));
+        }
+    }
+}
+
+/* 2000 drifting bodies over a 40k square without gravity, almost no pairs */
+static void Bench_BuildSparse(World *world)
+{
+    int count = 2000;
+
+    Vector2_SetZero(&world->gravity);
+    World_Reserve(world, count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        Body body;
+        Vector2 position = {Bench_Range(-20000.0f, 20000.0f), Bench_Range(-20000.0f, 20000.0f)};
+
+        if (Bench_Random() % 2 == 0)
+        {
+            Body_NewBox(&body, &world->shapes, position, 3.0f, 3.0f, 50.0f, 0.0f, 0.5f, false);
+        }
+        else
+        {
+            Body_NewCircle(&body, &world->shapes, position, 2.0f, 50.0f, 0.0f, 0.5f, false);
+        }
+
+        Vector2_Set(&body.linearVelocity, Bench_Range(-50.0f, 50.0f), Bench_Range(-50.0f, 50.0f));
+        World_AddBody(world, &body);
+    }
+}
+
+static const BenchScene scenes[] = {
+    {"pyramid", Bench_BuildPyramid},
+    {"rain", Bench_BuildRain},
+    {"pile", Bench_BuildPile},
+    {"hulls", Bench_BuildHulls},
+    {"sparse", Bench_BuildSparse}
+};
+
+/*
+    Builds the scene, or with a cache directory loads it from <cache>/<scene>.pine,
+    building and saving it there the first time.
+*/
+static World *Bench_Setup(const BenchScene *scene, const char *cache)
+{
+    char path[1024];
+    World *world = NULL;
+
+    if (cache != NULL)
+    {
+        snprintf(path, sizeof(path), "%s/%s.pine", cache, scene->name);
+
+        FILE *file = fopen(path, "rb");
+
+        if (file != NULL)
+        {
+            fclose(file);
+
+            if (WorldFile_Load(&world, path, NULL, NULL))
+            {
+                return world;
+            }
+        }
+    }
+
+    Vector2 gravity = {0.0f, 490.0f};
+    World_Create(&world, gravity);
+
+    if (world == NULL)
+    {
+        return NULL;
+    }
+
+    benchState = BENCH_SEED;
+    scene->build(world);
+
+    if (cache != NULL && !WorldFile_Save(world, path, NULL))
+    {
+        fprintf(stderr, "Error when caching the %s scene.\n", scene->name);
+    }
+
+    return world;
+}
+
+static BenchResult Bench_Run(const BenchScene *scene, BroadPhaseType type, WorldNarrowPhase narrowPhase, 
+                            int steps, int threads, bool colored, bool sleeping, bool adaptive, const char *cache)
+{
+    BenchResult result = {0, steps, 0.0, 0.0, 0, 0, 0};
+
+    double setup = Bench_Seconds();
+    World *world = Bench_Setup(scene, cache);
+
+    if (world == NULL)
+    {
+        return result;
+    }
+
+    World_SetBroadPhase(world, type);
+    World_SetNarrowPhase(world, narrowPhase);
+    World_SetThreadCount(world, threads);
+    World_SetParallelResolve(world, colored);
+    World_SetSleeping(world, sleeping);
+    World_SetAdaptiveSubsteps(world, adaptive, WORLD_MIN_SUBSTEPS, BENCH_ITERATIONS);
+
+    result.setupSeconds = Bench_Seconds() - setup;
+
+    double start = Bench_Seconds();
+
+    for (int i = 0; i < steps; ++i)
+    {
+        World_Step(world, BENCH_ITERATIONS, BENCH_TIME_STEP);
+
+        result.pairTests += world->pairCount;
+        result.contacts += world->contactCount;
+        result.substeps += world->stats.substepCount;
+    }
+
+    result.seconds = Bench_Seconds() - start;
+    result.bodies = world->bodies.length;
+
+    World_Destroy(&world);
+
+    return result;
+}
+
+/*
+    IntersectPolygon and IntersectConvexGJK against the scalar reference on random
+    rotated box pairs, roughly half of them overlapping. Also checks that they agree.
+    Normals and centers are precomputed for IntersectPolygon, as BodyList_UpdateBox
+    caches them.
+*/
+static bool Bench_Intersect(int kernel, int i, int j, Vector2 *normal, float *depth)
+{
+    if (kernel == 0)
+    {
+        return IntersectPolygonScalar(benchPolygons[i], 4, benchPolygons[j], 4, normal, depth);
+    }
+
+    if (kernel == 2)
+    {
+        return IntersectConvexGJK(benchPolygons[i], 4, 0.0f, benchCenters[i], 
+                                benchPolygons[j], 4, 0.0f, benchCenters[j], normal, depth);
+    }
+
+    return IntersectPolygon(benchPolygons[i], benchNormals[i], 4, benchCenters[i], 
+                            benchPolygons[j], benchNormals[j], 4, benchCenters[j], normal, depth);
+}
+
+static void Bench_RunSAT(void)
+{
+
+    benchState = BENCH_SEED;
+
+    for (int i = 0; i < BENCH_SAT_POLYGONS; ++i)
+    {
+        Vector2 local[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+
+        Transform transform;
+        Transform_Set(&transform, Bench_Range(0.0f, 120.0f), Bench_Range(0.0f, 120.0f), Bench_Range(0.0f, (float)PI));
+
+        float width = Bench_Range(10.0f, 40.0f);
+        float height = Bench_Range(10.0f, 40.0f);
+
+        for (int v = 0; v < 4; ++v)
+        {
+            Vector2 scaled = {local[v][0] * width, local[v][1] * height};
+            Vector2_Transformv(&benchPolygons[i][v], scaled, transform);
+        }
+
+        for (int v = 0; v < 4; ++v)
+        {
+            Vector2 edge;
+            Vector2_Sub(&edge, benchPolygons[i][(v + 1) % 4], benchPolygons[i][v]);
+            Vector2_Normal(&benchNormals[i][v], edge);
+            Vector2_Normalizedl(&benchNormals[i][v]);
+        }
+
+        PolygonGetCenter(&benchCenters[i], benchPolygons[i], 4);
+    }
+
+    const char *names[3] = {"scalar", "simd", "gjk"};
+
+    int hits[3] = {0, 0, 0};
+    double seconds[3] = {0.0, 0.0, 0.0};
+    long long tests = (long long)BENCH_SAT_ROUNDS * BENCH_SAT_POLYGONS;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        double start = Bench_Seconds();
+
+        for (int r = 0; r < BENCH_SAT_ROUNDS; ++r)
+        {
+            for (int i = 0; i < BENCH_SAT_POLYGONS; ++i)
+            {
+                int j = (i + r + 1) % BENCH_SAT_POLYGONS;
+
+                Vector2 normal;
+                float depth;
+
+                hits[k] += Bench_Intersect(k, i, j, &normal, &depth);
+            }
+        }
+
+        seconds[k] = Bench_Seconds() - start;
+    }
+
+    float maxError = 0.0f;
+    int mismatches = 0;
+
+    for (int i = 0; i < BENCH_SAT_POLYGONS; ++i)
+    {
+        int j = (i + 1) % BENCH_SAT_POLYGONS;
+
+        for (int k = 1; k < 3; ++k)
+        {
+            Vector2 normal0, normal1;
+            float depth0, depth1;
+
+            bool hit0 = Bench_Intersect(0, i, j, &normal0, &depth0);
+            bool hit1 = Bench_Intersect(k, i, j, &normal1, &depth1);
+
+            if (hit0 != hit1)
+            {
+                mismatches++;
+            }
+            else if (hit0)
+            {
+                maxError = fmaxf(maxError, fabsf(depth0 - depth1));
+                maxError = fmaxf(maxError, fabsf(normal0[0] - normal1[0]) + fabsf(normal0[1] - normal1[1]));
+            }
+        }
+    }
+
+    printf("kernel,tests,seconds,ns_per_test,hits,speedup\n");
+
+    for (int k = 0; k < 3; ++k)
+    {
+        printf("%s,%lld,%.6f,%.3f,%i,%.3f\n", names[k], tests, seconds[k], seconds[k] * 1e9 / tests, 
+                hits[k], (seconds[k] > 0.0) ? seconds[0] / seconds[k] : 0.0);
+    }
+
+    fprintf(stderr, "mismatches %i, max depth/normal error %g\n", mismatches, maxError);
+}
+
+/*
+    Settles the pyramid with the engine's configuration and checks that the adaptive
+    substeps drop back to the minimum and the pile falls asleep before BENCH_SETTLE_STEPS.
+    Prints the first step from which each held, -1 when it never did.
+*/
+static int Bench_RunSettle(void)
+{
+    World *world;
+    Vector2 gravity = {0.0f, 490.0f};
+    World_Create(&world, gravity);
+
+    if (world == NULL)
+    {
+        return 1;
+    }
+
+    Replay_ConfigureWorld(world);
+
+    benchState = BENCH_SEED;
+    Bench_BuildPyramid(world);
+
+    int minimumStep = -1;
+    int asleepStep = -1;
+
+    for (int i = 0; i < BENCH_SETTLE_STEPS; ++i)
+    {
+        World_Step(world, BENCH_ITERATIONS, BENCH_TIME_STEP);
+
+        if (world->stats.substepCount > world->minSubsteps)
+        {
+            minimumStep = -1;
+        }
+        else if (minimumStep < 0)
+        {
+            minimumStep = i;
+        }
+
+        if (world->stats.awakeCount > 0)
+        {
+            asleepStep = -1;
+        }
+        else if (asleepStep < 0)
+        {
+            asleepStep = i;
+        }
+    }
+
+    printf("scene,steps,minimum_step,asleep_step,substeps,reason,awake\n");
+    printf("pyramid,%i,%i,%i,%i,%s,%i\n", BENCH_SETTLE_STEPS, minimumStep, asleepStep, world->stats.substepCount,
+            World_SubstepReasonName(world->stats.substepReason), world->stats.awakeCount);
+
+    bool settled = minimumStep >= 0 && asleepStep >= 0;
+
+    if (!settled)
+    {
+        fprintf(stderr, "Error the pyramid did not settle in %i steps.\n", BENCH_SETTLE_STEPS);
+    }
+
+    World_Destroy(&world);
+
+    return settled ? 0 : 1;
+}
+
+static void Bench_Print(const BenchScene *scene, BroadPhaseType type, WorldNarrowPhase narrowPhase, int threads, 
+                        BenchResult result, bool json, bool first)
+{
+    double stepsPerSecond = (result.seconds > 0.0) ? result.steps / result.seconds : 0.0;
+    double substeps = (result.steps > 0) ? (double)result.substeps / result.steps : 0.0;
+    double bodySubsteps = (double)result.substeps * result.bodies;
+    double nsPerBody = (bodySubsteps > 0.0) ? result.seconds * 1e9 / bodySubsteps : 0.0;
+
+    if (json)
+    {
+        printf("%s  {\"scene\": \"%s\", \"broadphase\": \"%s\", \"threads\": %i, \"bodies\": %i, \"steps\": %i, "
+                "\"substeps\": %.2f, \"seconds\": %.6f, \"steps_per_sec\": %.3f, "
+                "\"ns_per_body_substep\": %.3f, \"pair_tests\": %lld, \"contacts\": %lld, \"setup_seconds\": %.6f, "
+                "\"narrowphase\": \"%s\"}",
+                first ? "" : ",\n", scene->name, BroadPhase_Name(type), threads, result.bodies, result.steps,
+                substeps, result.seconds, stepsPerSecond, nsPerBody, result.pairTests, result.contacts,
+                result.setupSeconds, World_NarrowPhaseName(narrowPhase));
+    }
+    else
+    {
+        printf("%s,%s,%i,%i,%i,%.2f,%.6f,%.3f,%.3f,%lld,%lld,%.6f,%s\n",
+                scene->name, BroadPhase_Name(type), threads, result.bodies, result.steps,
+                substeps, result.seconds, stepsPerSecond, nsPerBody, result.pairTests, result.contacts,
+                result.setupSeconds, World_NarrowPhaseName(narrowPhase));
+    }
+}
+
+/*
+    Runs the seeded scenes headlessly and prints one row per scene.
+    usage: bench.out [--json] [--steps N] [--broadphase 0..3] [--threads N] [--colored] [--sleep] [--adaptive] 
+                     [--gjk] [--cache DIR] [scene]
+           --gjk tests polygon pairs with GJK/EPA instead of SAT
+           --cache loads the scenes from world files in DIR, saved there on the first run
+           bench.out --sat     (IntersectPolygon and IntersectConvexGJK microbenchmark)
+           bench.out --settle  (the pyramid must reach the minimum substeps and sleep, exits 1 otherwise)
+*/
+int main(int argc, char *args[])
+{
+    bool json = false;
+    int steps = BENCH_DEFAULT_STEPS;
+    BroadPhaseType type = BroadPhase_Grid;
+    WorldNarrowPhase narrowPhase = WorldNarrowPhase_SAT;
+    int threads = 1;
+    bool colored = false;
+    bool sleeping = false;
+    bool adaptive = false;
+    const char *only = NULL;
+    const char *cache = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(args[i], "--sat") == 0)
+        {
+            Bench_RunSAT();
+            return 0;
+        }
+        else if (strcmp(args[i], "--settle") == 0)
+        {
+            return Bench_RunSettle();
+        }
+        else if (strcmp(args[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else if (strcmp(args[i], "--steps") == 0 && i + 1 < argc)
+        {
+            steps = atoi(args[++i]);
+        }
+        else if (strcmp(args[i], "--broadphase") == 0 && i + 1 < argc)
+        {
+            type = (BroadPhaseType)atoi(args[++i]);
+        }
+        else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(args[++i]);
+        }
+        else if (strcmp(args[i], "--colored") == 0)
+        {
+            colored = true;
+        }
+        else if (strcmp(args[i], "--sleep") == 0)
+        {
+            sleeping = true;
+        }
+        else if (strcmp(args[i], "--adaptive") == 0)
+        {
+            adaptive = true;
+        }
+        else if (strcmp(args[i], "--gjk") == 0)
+        {
+            narrowPhase = WorldNarrowPhase_GJK;
+        }
+        else if (strcmp(args[i], "--cache") == 0 && i + 1 < argc)
+        {
+            cache = args[++i];
+        }
+        else
+        {
+            only = args[i];
+        }
+    }
+
+    if (type < 0 || type >= BroadPhase_Count)
+    {
+        fprintf(stderr, "Error unknown broad-phase %i.\n", type);
+        return 1;
+    }
+
+    if (json)
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("scene,broadphase,threads,bodies,steps,substeps,seconds,steps_per_sec,ns_per_body_substep,pair_tests,contacts,setup_seconds,narrowphase\n");
+    }
+
+    bool first = true;
+    int sceneCount = sizeof(scenes) / sizeof(scenes[0]);
+
+    for (int i = 0; i < sceneCount; ++i)
+    {
+        if (only != NULL && strcmp(only, scenes[i].name) != 0)
+        {
+            continue;
+        }
+
+        BenchResult result = Bench_Run(&scenes[i], type, narrowPhase, steps, threads, colored, sleeping, 
+                                    adaptive, cache);
+        Bench_Print(&scenes[i], type, narrowPhase, threads, result, json, first);
+        fflush(stdout);
+
+        first = false;
+    }
+
+    if (json)
+    {
+        printf("\n]\n");
+    }
+
+    return 0;
+}
@@ -1,13 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <SDL2/SDL.h>
+#include <string.h>
+#include <float.h>
 #include <math.h>
 #include "body.h"
-#include "engine.h"
 #include "world.h"
+#include "alloc.h"
+#include "collision.h"
+#include "simd.h"
 
-bool Body_NewBox(Body *body, Vector2 position, float width, float height, float mass,
-                 float rotation, float resistituion, bool isStatic)
+bool Body_NewBox(Body *body, ShapeLibrary *library, Vector2 position, float width, float height, 
+                float mass, float rotation, float resistituion, bool isStatic)
 {
     Vector2_Setv(&body->position, position);
 
@@ -27,19 +30,20 @@ bool Body_NewBox(Body *body, Vector2 position, float width, float height, float
 
     body->resistituion = resistituion;
 
+    body->shapeId = ShapeLibrary_AcquireBox(library, body->width, body->height);
+    body->transformedVertices = NULL;
     body->vertLength = 4;
-    body->vertices = calloc(body->vertLength, sizeof(Vector2));
-    body->transformedVertices = calloc(body->vertLength, sizeof(Vector2));
 
-    if (body->vertices == NULL || body->transformedVertices == NULL)
+    if (body->shapeId == -1)
     {
         printf("Error creating new vertices\n");
         return false;
     }
- 
-    Body_UpdateBox(body);
+
+    body->boundingRadius = ShapeLibrary_Get(library, body->shapeId)->boundingRadius;
 
     body->isStatic = isStatic;
+    body->isDead = false;
     body->shape = Box;
 
     Vector2_SetZero(&body->force);
@@ -48,7 +52,7 @@ bool Body_NewBox(Body *body, Vector2 position, float width, float height, float
     return true;
 }
 
-bool Body_NewCircle(Body *body, Vector2 center, float radius, float mass, 
+bool Body_NewCircle(Body *body, ShapeLibrary *library, Vector2 center, float radius, float mass, 
                 float rotation, float resistituion, bool isStatic)
 {
     Vector2_Setv(&body->position, center);
@@ -67,7 +71,20 @@ bool Body_NewCircle(Body *body, Vector2 center, float radius, float mass,
 
     body->resistituion = resistituion;
 
+    body->shapeId = ShapeLibrary_AcquireCircle(library, body->radius);
+    body->transformedVertices = NULL;
+    body->vertLength = 0;
+
+    if (body->shapeId == -1)
+    {
+        printf("Error creating new circle shape\n");
+        return false;
+    }
+
+    body->boundingRadius = body->radius;
+
     body->isStatic = isStatic;
+    body->isDead = false;
     body->shape = Circle;
 
     Vector2_SetZero(&body->force);
@@ -76,198 +93,334 @@ bool Body_NewCircle(Body *body, Vector2 center, float radius, float mass,
     return true;
 }
 
-void Body_Debug(Body *body, Window *window, Color color)
+static int Body_ComparePoints(const void *a, const void *b)
 {
-    SDL_SetRenderDrawColor(window->renderer, color.r, color.g, color.b, color.a);
+    const float *p0 = (const float *)a;
+    const float *p1 = (const float *)b;
 
-    switch (body->shape)
+    if (p0[0] != p1[0])
     {
-        case Box:
-
-
-            float minY = FLT_MAX, maxY = -FLT_MAX;
+        return (p0[0] < p1[0]) ? -1 : 1;
+    }
 
-            for (int i = 0; i < 4; i++) 
-            {
-                if (body->transformedVertices[i][1] < minY) minY = body->transformedVertices[i][1];
-                if (body->transformedVertices[i][1] > maxY) maxY = body->transformedVertices[i][1];
-            }
+    return (p0[1] < p1[1]) ? -1 : (p0[1] > p1[1]);
+}
 
-            for (int y = (int)minY; y <= (int)maxY; y++) 
-            {
+static float Body_Cross(Vector2 o, Vector2 a, Vector2 b)
+{
+    return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+}
 
-                float intersections[4];
-                int count = 0;
+/*
+    Andrew's monotone chain over sorted, hull gets the convex hull with a positive
+    PolygonGetArea and no collinear vertices. hull needs room for length + 1 points.
+*/
+static int Body_ConvexHull(Vector2 *sorted, int length, Vector2 *hull)
+{
+    qsort(sorted, length, sizeof(Vector2), Body_ComparePoints);
 
-                for (int i = 0; i < 4; i++) 
-                {
-                    int next = (i + 1) % 4;
+    int count = 0;
 
-                    if ((body->transformedVertices[i][1] <= y && body->transformedVertices[next][1] > y) || (body->transformedVertices[next][1] <= y && body->transformedVertices[i][1] > y)) 
-                    {
-                        float x = body->transformedVertices[i][0] + (y - body->transformedVertices[i][1]) * (body->transformedVertices[next][0] - body->transformedVertices[i][0]) / (body->transformedVertices[next][1] - body->transformedVertices[i][1]);
-                        intersections[count++] = x;
-                    }
-                }
+    for (int i = 0; i < length; ++i)
+    {
+        while (count >= 2 && Body_Cross(hull[count - 2], hull[count - 1], sorted[i]) <= 0.0f)
+        {
+            count--;
+        }
 
-                for (int i = 0; i < count - 1; i++) 
-                {
-                    for (int j = i + 1; j < count; j++) 
-                    {
-                        if (intersections[j] < intersections[i]) 
-                        {
-                            float temp = intersections[i];
-                            intersections[i] = intersections[j];
-                            intersections[j] = temp;
-                        }
-                    }
-                }
+        Vector2_Setv(&hull[count++], sorted[i]);
+    }
 
-                for (int i = 0; i < count; i += 2) 
-                {
-                    if (i + 1 < count) 
-                    {
-                        SDL_RenderDrawLine(window->renderer, (int)intersections[i], y, (int)intersections[i + 1], y);
-                    }
-                }
-            }
-        break;
+    for (int i = length - 2, lower = count + 1; i >= 0; --i)
+    {
+        while (count >= lower && Body_Cross(hull[count - 2], hull[count - 1], sorted[i]) <= 0.0f)
+        {
+            count--;
+        }
 
-        case Circle:
-            for (int y = -body->radius; y <= body->radius; y++) 
-            {
-                for (int x = -body->radius; x <= body->radius; x++) 
-                {
-                    if (x * x + y * y < body->radius * body->radius) 
-                    {
-                        SDL_RenderDrawPoint(window->renderer,
-                                            body->position[0] + x, 
-                                            body->position[1] + y);
-                    }
-                }
-            }
-        break;
+        Vector2_Setv(&hull[count++], sorted[i]);
     }
 
-    SDL_SetRenderDrawColor(window->renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    /* the last point closes the loop on the first */
+    return (count > 1) ? count - 1 : count;
 }
 
-void Body_Step(Body *body, World *world, int interations, float time)
+/*
+    Convex polygon from the hull of points, given around the body like box sizes
+    (scaled the same way). The hull is moved so its centroid sits on position and
+    the density comes from its area. Fails when there are more than
+    BODY_MAX_POLYGON_POINTS points, or the hull has less than 3 or more than
+    SHAPE_MAX_VERTICES vertices.
+*/
+bool Body_NewPolygon(Body *body, ShapeLibrary *library, Vector2 position, Vector2 *points, int length, 
+                float mass, float rotation, float resistituion, bool isStatic)
 {
-    if (body->isStatic)
+    Vector2 sorted[BODY_MAX_POLYGON_POINTS];
+    Vector2 hull[BODY_MAX_POLYGON_POINTS + 1];
+
+    if (length > BODY_MAX_POLYGON_POINTS)
     {
-        return;
+        printf("Error a polygon takes at most %i points, not %i.\n", BODY_MAX_POLYGON_POINTS, length);
+        return false;
     }
 
-    time = time / (float)interations;
+    if (length > 0)
+    {
+        memcpy(sorted, points, length * sizeof(Vector2));
+    }
+
+    int count = (length > 0) ? Body_ConvexHull(sorted, length, hull) : 0;
 
-    /*
-        f = m * a
-        > a = f/m
-    */
-    //Vector2 accelaration;
-    //Vector2_Div(&accelaration, body->force, body->mass);
+    if (count < 3 || count > SHAPE_MAX_VERTICES)
+    {
+        printf("Error the hull of a polygon needs 3 to %i vertices, not %i.\n", SHAPE_MAX_VERTICES, count);
+        return false;
+    }
 
-    /*
-        a = (vf - vi)/t
-        a * t = (vf - vi)
-        vf = vi + a * t
+    float volume = PolygonGetArea(hull, count);
 
-        > vf = vi + a*t
-    */
+    Vector2 center;
+    PolygonGetCenter(&center, hull, count);
 
-    //Vector2_Multl(&accelaration, time);
-    //Vector2_Addl(body->linearVelocity, accelaration);
+    Vector2 vertices[SHAPE_MAX_VERTICES];
+    Vector2 min = {FLT_MAX, FLT_MAX};
+    Vector2 max = {-FLT_MAX, -FLT_MAX};
 
-    Vector2 gravity;
-    Vector2_Setv(&gravity, world->gravity);
-    Vector2_Multl(&gravity, time);
-    Vector2_Addl(body->linearVelocity, gravity);
+    for (int i = 0; i < count; ++i)
+    {
+        Vector2_Sub(&vertices[i], hull[i], center);
+        Vector2_Multl(&vertices[i], 10.0f);
 
-    
+        min[0] = fminf(min[0], vertices[i][0]);
+        min[1] = fminf(min[1], vertices[i][1]);
+        max[0] = fmaxf(max[0], vertices[i][0]);
+        max[1] = fmaxf(max[1], vertices[i][1]);
+    }
 
-    /*
-        v = s/t;
-        s = v * t;
-        s = xf - xi;
-        xf = xi + s
+    Vector2_Setv(&body->position, position);
 
-        > xf = xi + (v * t)
-    */
+    body->width = max[0] - min[0];
+    body->height = max[1] - min[1];
+    body->radius = 0.0f;
 
-    Vector2 currentVeloc;
-    Vector2_Mult(&currentVeloc, body->linearVelocity, time);
-    Vector2_Addl(body->position, currentVeloc);
-    Vector2_SetZero(body->force);
+    body->mass = mass;
+    body->invMass = (!isStatic) ? (1.0f/mass) : 0.0f;
+    body->density = mass/volume;
 
-    Body_UpdateBox(body);
-}
+    body->rotation = rotation;
+    body->rotationVelocity = 0.0f;
 
-void Body_AddForce(Body *body, Vector2 amount)
-{
-    Vector2_Setv(body->force, amount);
+    body->resistituion = resistituion;
+
+    body->shapeId = ShapeLibrary_AcquirePolygon(library, vertices, count);
+    body->transformedVertices = NULL;
+    body->vertLength = count;
+
+    if (body->shapeId == -1)
+    {
+        printf("Error creating new vertices\n");
+        return false;
+    }
+
+    body->boundingRadius = ShapeLibrary_Get(library, body->shapeId)->boundingRadius;
+
+    body->isStatic = isStatic;
+    body->isDead = false;
+    body->shape = Polygon;
+
+    Vector2_SetZero(&body->force);
+    Vector2_SetZero(&body->linearVelocity);
+
+    return true;
 }
 
-void Body_UpdateBox(Body *box)
+/*
+    vf = vi + a*t
+    xf = xi + (v * t)
+    Static (invMass 0) and sleeping (awake 0) bodies are masked out rather than
+    skipped, the lanes keep their old values so the result matches the scalar loop
+    bit for bit.
+*/
+static void Body_Integrate(BodyList *list, float gravityX, float gravityY, float time)
 {
-    if (box->shape == Box)
+    float *positionX = list->positionX;
+    float *positionY = list->positionY;
+    float *velocityX = list->velocityX;
+    float *velocityY = list->velocityY;
+    float *invMass = list->invMass;
+    float *awake = list->awake;
+
+    int i = 0;
+
+#if defined(SIMD_AVX2)
+    __m256 gx8 = _mm256_set1_ps(gravityX);
+    __m256 gy8 = _mm256_set1_ps(gravityY);
+    __m256 t8 = _mm256_set1_ps(time);
+    __m256 zero8 = _mm256_setzero_ps();
+
+    for (; i + 8 <= list->length; i += 8)
     {
-        Vector2_Set(box->vertices[0], (box->position[0] - (box->width / 2.0f)), 
-                                    (box->position[1] - (box->height / 2.0f)));
-        
-        Vector2_Set(box->vertices[1], (box->position[0] + (box->width / 2.0f)), 
-                                    (box->position[1] - (box->height / 2.0f)));
+        __m256 dynamic = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&invMass[i]), zero8, _CMP_NEQ_OQ), 
+                                    _mm256_cmp_ps(_mm256_loadu_ps(&awake[i]), zero8, _CMP_NEQ_OQ));
+
+        __m256 vx = _mm256_loadu_ps(&velocityX[i]);
+        __m256 vy = _mm256_loadu_ps(&velocityY[i]);
+        __m256 px = _mm256_loadu_ps(&positionX[i]);
+        __m256 py = _mm256_loadu_ps(&positionY[i]);
+
+        vx = _mm256_blendv_ps(vx, _mm256_add_ps(vx, gx8), dynamic);
+        vy = _mm256_blendv_ps(vy, _mm256_add_ps(vy, gy8), dynamic);
+        px = _mm256_blendv_ps(px, _mm256_add_ps(px, _mm256_mul_ps(vx, t8)), dynamic);
+        py = _mm256_blendv_ps(py, _mm256_add_ps(py, _mm256_mul_ps(vy, t8)), dynamic);
+
+        _mm256_storeu_ps(&velocityX[i], vx);
+        _mm256_storeu_ps(&velocityY[i], vy);
+        _mm256_storeu_ps(&positionX[i], px);
+        _mm256_storeu_ps(&positionY[i], py);
+    }
+#endif
 
-        Vector2_Set(box->vertices[2], (box->position[0] + (box->width / 2.0f)), 
-                                    (box->position[1] + (box->height / 2.0f)));
-        
-        Vector2_Set(box->vertices[3], (box->position[0] - (box->width / 2.0f)), 
-                                    (box->position[1] + (box->height / 2.0f)));
+#if defined(SIMD_SSE2)
+    __m128 gx4 = _mm_set1_ps(gravityX);
+    __m128 gy4 = _mm_set1_ps(gravityY);
+    __m128 t4 = _mm_set1_ps(time);
+    __m128 zero4 = _mm_setzero_ps();
 
-        for (int i = 0; i < box->vertLength; ++i)
-        {
-            Transform transform;
-            Transform_Set(&transform, 0.0f, 0.0f, box->rotation);
+    for (; i + 4 <= list->length; i += 4)
+    {
+        __m128 dynamic = _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(&invMass[i]), zero4), 
+                                    _mm_cmpneq_ps(_mm_loadu_ps(&awake[i]), zero4));
+
+        __m128 vx = _mm_loadu_ps(&velocityX[i]);
+        __m128 vy = _mm_loadu_ps(&velocityY[i]);
+        __m128 px = _mm_loadu_ps(&positionX[i]);
+        __m128 py = _mm_loadu_ps(&positionY[i]);
+
+        vx = _mm_or_ps(_mm_and_ps(dynamic, _mm_add_ps(vx, gx4)), _mm_andnot_ps(dynamic, vx));
+        vy = _mm_or_ps(_mm_and_ps(dynamic, _mm_add_ps(vy, gy4)), _mm_andnot_ps(dynamic, vy));
+        px = _mm_or_ps(_mm_and_ps(dynamic, _mm_add_ps(px, _mm_mul_ps(vx, t4))), _mm_andnot_ps(dynamic, px));
+        py = _mm_or_ps(_mm_and_ps(dynamic, _mm_add_ps(py, _mm_mul_ps(vy, t4))), _mm_andnot_ps(dynamic, py));
+
+        _mm_storeu_ps(&velocityX[i], vx);
+        _mm_storeu_ps(&velocityY[i], vy);
+        _mm_storeu_ps(&positionX[i], px);
+        _mm_storeu_ps(&positionY[i], py);
+    }
+#endif
 
-            Vector2_Sub(&box->transformedVertices[i], box->vertices[i], box->position);
-            Vector2_Transformvl(&box->transformedVertices[i], transform);
-            Vector2_Addl(&box->transformedVertices[i], box->position);
+    for (; i < list->length; ++i)
+    {
+        if (invMass[i] == 0.0f || awake[i] == 0.0f)
+        {
+            continue;
         }
+
+        velocityX[i] = velocityX[i] + gravityX;
+        velocityY[i] = velocityY[i] + gravityY;
+
+        positionX[i] = positionX[i] + velocityX[i] * time;
+        positionY[i] = positionY[i] + velocityY[i] * time;
     }
 }
 
-void Body_Move(Body *body, Vector2 amount)
+/*
+    result = rotate(local) + position, same operation order as Vector2_Transformv.
+    Two interleaved vertices per SSE register: x*cos + y*-sin and y*cos + x*sin
+    come out of one multiply of the vertices and one of their swapped copy.
+*/
+static void Body_TransformVertices(Vector2 *result, Vector2 *local, int length, Transform transform)
 {
-    Vector2_Addl(&body->position, amount);
-    Body_UpdateBox(body);
+    int i = 0;
+
+#if defined(SIMD_SSE2)
+    float x = transform[0][0];
+    float y = transform[0][1];
+    float c = transform[1][0];
+    float s = transform[1][1];
+
+    __m128 cos4 = _mm_set1_ps(c);
+    __m128 sin4 = _mm_setr_ps(-s, s, -s, s);
+    __m128 position = _mm_setr_ps(x, y, x, y);
+
+    for (; i + 2 <= length; i += 2)
+    {
+        __m128 v = _mm_loadu_ps(&local[i][0]);
+        __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+
+        __m128 rotated = _mm_add_ps(_mm_mul_ps(v, cos4), _mm_mul_ps(swapped, sin4));
+        _mm_storeu_ps(&result[i][0], _mm_add_ps(position, rotated));
+    }
+#endif
+
+    for (; i < length; ++i)
+    {
+        Vector2_Transformv(&result[i], local[i], transform);
+    }
 }
 
-void Body_Destroy(Body *body)
+void Body_Step(BodyList *list, World *world, int interations, float time)
 {
-    if (body->vertices != NULL)
+    time = time / (float)interations;
+
+    float gravityX = world->gravity[0] * time;
+    float gravityY = world->gravity[1] * time;
+
+    Body_Integrate(list, gravityX, gravityY, time);
+
+    for (int i = 0; i < list->length; ++i)
     {
-        free(body->vertices);
+        if (list->invMass[i] != 0.0f && list->awake[i] != 0.0f && list->bodies[i].shape != Circle)
+        {
+            BodyList_UpdateBox(list, i);
+        }
     }
+}
 
-    if (body->transformedVertices != NULL)
+void Body_AddForce(Body *body, Vector2 amount)
+{
+    Vector2_Setv(body->force, amount);
+}
+
+static void Body_UpdateVertices(Body *box, ShapeLibrary *library, Vector2 *result, float x, float y)
+{
+    Transform transform;
+    Transform_Set(&transform, x, y, box->rotation);
+
+    Body_TransformVertices(result, ShapeLibrary_GetVertices(library, box->shapeId), box->vertLength, transform);
+}
+
+void Body_UpdateBox(Body *box, ShapeLibrary *library)
+{
+    if (box->shape != Circle && box->transformedVertices != NULL)
     {
-        free(body->transformedVertices);
+        Body_UpdateVertices(box, library, box->transformedVertices, box->position[0], box->position[1]);
     }
 }
 
-void Body_GetAABB(Body *body)
+void Body_Move(Body *body, ShapeLibrary *library, Vector2 amount)
+{
+    Vector2_Addl(&body->position, amount);
+    Body_UpdateBox(body, library);
+}
+
+void Body_Destroy(Body *body, ShapeLibrary *library)
+{
+    ShapeLibrary_Release(library, body->shapeId);
+}
+
+static void Body_ComputeAABB(Body *body, Vector2 *vertices, float x, float y)
 {
     float minX = FLT_MAX;
     float minY = FLT_MAX;
-    float maxX = FLT_MIN;
-    float maxY = FLT_MIN;
+    float maxX = -FLT_MAX;
+    float maxY = -FLT_MAX;
 
-    if (body->shape == Box)
+    if (body->shape != Circle)
     {
         for (int i = 0; i < body->vertLength; ++i)
         {
             Vector2 point;
-            Vector2_Setv(&point, body->transformedVertices[i]);
+            Vector2_Setv(&point, vertices[i]);
 
             if (point[0] < minX) minX = point[0];
             if (point[0] > maxX) maxX = point[0];
@@ -278,81 +431,274 @@ void Body_GetAABB(Body *body)
     }
     else
     {
-        minX = body->position[0] - body->radius;
-        minY = body->position[1] - body->radius;
+        minX = x - body->radius;
+        minY = y - body->radius;
 
-        maxX = body->position[0] + body->radius;
-        maxY = body->position[1] + body->radius;
+        maxX = x + body->radius;
+        maxY = y + body->radius;
     }
     
     body->aabb[0][0] = minX;
-    body->aabb[0][1] = minX;
+    body->aabb[0][1] = minY;
     body->aabb[1][0] = maxX;
     body->aabb[1][1] = maxY;
 }
 
-void BodyList_Create(BodyList *list)
+void Body_GetAABB(Body *body)
+{
+    Body_ComputeAABB(body, body->transformedVertices, body->position[0], body->position[1]);
+}
+
+bool BodyList_Reserve(BodyList *list, int capacity)
 {
+    if (capacity <= list->capacity)
+    {
+        return true;
+    }
+
+    float **arrays[10] = {&list->positionX, &list->positionY, 
+                        &list->velocityX, &list->velocityY, 
+                        &list->invMass, &list->resistituion,
+                        &list->awake, &list->sleepTime,
+                        &list->previousX, &list->previousY};
+
+    for (int i = 0; i < 10; ++i)
+    {
+        float *temp = (float *)Alloc_Realloc(*arrays[i], capacity * sizeof(float));
+
+        if (temp == NULL)
+        {
+            return false;
+        }
+
+        *arrays[i] = temp;
+    }
+
+    int **indices[2] = {&list->slots, &list->slotIndex};
+
+    for (int i = 0; i < 2; ++i)
+    {
+        int *temp = (int *)Alloc_Realloc(*indices[i], capacity * sizeof(int));
+
+        if (temp == NULL)
+        {
+            return false;
+        }
+
+        *indices[i] = temp;
+    }
+
+    Uint32 *generations = (Uint32 *)Alloc_Realloc(list->slotGeneration, capacity * sizeof(Uint32));
+
+    if (generations == NULL)
+    {
+        return false;
+    }
+
+    list->slotGeneration = generations;
+
+    Vector2 *vertices = (Vector2 *)Alloc_Realloc(list->vertices, capacity * SHAPE_MAX_VERTICES * sizeof(Vector2));
+
+    if (vertices == NULL)
+    {
+        return false;
+    }
+
+    list->vertices = vertices;
+
+    Vector2 *normals = (Vector2 *)Alloc_Realloc(list->normals, capacity * SHAPE_MAX_VERTICES * sizeof(Vector2));
+
+    if (normals == NULL)
+    {
+        return false;
+    }
+
+    list->normals = normals;
+
+    Vector2 *centroids = (Vector2 *)Alloc_Realloc(list->centroids, capacity * sizeof(Vector2));
+
+    if (centroids == NULL)
+    {
+        return false;
+    }
+
+    list->centroids = centroids;
+
+    Body *temp = (Body *)Alloc_Realloc(list->bodies, capacity * sizeof(Body));
+
+    if (temp == NULL)
+    {
+        return false;
+    }
+
+    list->bodies = temp;
+    list->capacity = capacity;
+
+    return true;
+}
+
+void BodyList_Create(BodyList *list, ShapeLibrary *library)
+{
+    list->positionX = NULL;
+    list->positionY = NULL;
+    list->velocityX = NULL;
+    list->velocityY = NULL;
+    list->invMass = NULL;
+    list->resistituion = NULL;
+    list->awake = NULL;
+    list->sleepTime = NULL;
+    list->previousX = NULL;
+    list->previousY = NULL;
+    list->vertices = NULL;
+    list->normals = NULL;
+    list->centroids = NULL;
+
+    list->slots = NULL;
+    list->slotIndex = NULL;
+    list->slotGeneration = NULL;
+    list->slotLength = 0;
+    list->freeSlot = -1;
+
+    list->library = library;
+
     list->bodies = NULL;
     list->length = 0;
+    list->capacity = 0;
 }
 
-void BodyList_Push(BodyList *list, Body *body)
+BodyHandle BodyList_Push(BodyList *list, Body *body)
 {
-    int len = list->length + 1;
-    list->bodies = realloc(list->bodies, len * sizeof(Body));
+    BodyHandle handle = {-1, 0};
 
-    if (list->bodies == NULL)
+    if (list->length == list->capacity)
     {
-        printf("Error when creating the bodies list.\n");
-        return;
+        int capacity = (list->capacity > 0) ? list->capacity * 2 : 64;
+
+        if (!BodyList_Reserve(list, capacity))
+        {
+            printf("Error when creating the bodies list.\n");
+            return handle;
+        }
     }
-    
+
+    int slot = list->freeSlot;
+
+    if (slot != -1)
+    {
+        list->freeSlot = list->slotIndex[slot];
+    }
+    else
+    {
+        slot = list->slotLength++;
+        list->slotGeneration[slot] = 0;
+    }
+
+    int index = list->length++;
+
     Body result = (*body);
-    result.vertices = NULL;
     result.transformedVertices = NULL;
-    result.vertLength = 0;
+    result.isDead = false;
 
-    if (body->shape == Box)
-    {
-        result.vertLength = 4;
-        result.vertices = (Vector2 *)calloc(result.vertLength, sizeof(Vector2));
-        result.transformedVertices = (Vector2 *)calloc(result.vertLength, sizeof(Vector2));
+    list->bodies[index] = result;
+    list->slots[index] = slot;
+    list->slotIndex[slot] = index;
 
-        if (result.vertices == NULL || result.transformedVertices == NULL)
-        {
-            printf("Error in allocating memory for vertices.\n");
-            return;
-        }
+    BodyList_Set(list, index, body);
+    BodyList_UpdateBox(list, index);
+
+    list->previousX[index] = list->positionX[index];
+    list->previousY[index] = list->positionY[index];
+
+    handle.slot = slot;
+    handle.generation = list->slotGeneration[slot];
 
-        memcpy(result.vertices, body->vertices, result.vertLength * sizeof(Vector2));
-        memcpy(result.transformedVertices, body->transformedVertices, result.vertLength * sizeof(Vector2));
-    }   
+    return handle;
+}
 
-    list->bodies[len - 1] = result;
-    list->length = len;
+/* moves body from into index to, handle included */
+static void BodyList_Copy(BodyList *list, int to, int from)
+{
+    list->positionX[to] = list->positionX[from];
+    list->positionY[to] = list->positionY[from];
+    list->velocityX[to] = list->velocityX[from];
+    list->velocityY[to] = list->velocityY[from];
+    list->invMass[to] = list->invMass[from];
+    list->resistituion[to] = list->resistituion[from];
+    list->awake[to] = list->awake[from];
+    list->sleepTime[to] = list->sleepTime[from];
+    list->previousX[to] = list->previousX[from];
+    list->previousY[to] = list->previousY[from];
+    memcpy(BodyList_GetVertices(list, to), BodyList_GetVertices(list, from), 
+            SHAPE_MAX_VERTICES * sizeof(Vector2));
+    memcpy(BodyList_GetNormals(list, to), BodyList_GetNormals(list, from), 
+            SHAPE_MAX_VERTICES * sizeof(Vector2));
+    Vector2_Setv(&list->centroids[to], list->centroids[from]);
+    list->bodies[to] = list->bodies[from];
+
+    list->slots[to] = list->slots[from];
+    list->slotIndex[list->slots[to]] = to;
+}
+
+static void BodyList_FreeSlot(BodyList *list, int slot)
+{
+    list->slotGeneration[slot]++;
+    list->slotIndex[slot] = list->freeSlot;
+    list->freeSlot = slot;
 }
 
 void BodyList_Remove(BodyList *list, int index)
 {
-    for (int i = index; i < list->length - 1; ++i)
-    {
-        list->bodies[i] = list->bodies[i + 1];
-    }   
+    int last = list->length - 1;
+    int slot = list->slots[index];
 
-    int len = list->length - 1;
-    Body *temp = (Body *)realloc(list->bodies, len * sizeof(Body));
+    Body_Destroy(&list->bodies[index], list->library);
 
-    if (temp == NULL)
+    /* swap the last body into the hole, its handle follows it */
+    if (index != last)
     {
-        printf("Error when reallocating the bodies.\n");
-        return;
+        BodyList_Copy(list, index, last);
     }
 
-    list->bodies = temp;
-    list->length = len; 
+    BodyList_FreeSlot(list, slot);
+
+    list->length = last;
 }
 
+/*
+    Removes every body marked isDead in one stable pass, the survivors keep their
+    order. remap[i] receives the new index of old body i, -1 if it was removed.
+    Returns how many bodies were removed.
+*/
+int BodyList_Compact(BodyList *list, int *remap)
+{
+    int length = 0;
+
+    for (int i = 0; i < list->length; ++i)
+    {
+        if (list->bodies[i].isDead)
+        {
+            int slot = list->slots[i];
+
+            Body_Destroy(&list->bodies[i], list->library);
+            BodyList_FreeSlot(list, slot);
+
+            remap[i] = -1;
+            continue;
+        }
+
+        if (length != i)
+        {
+            BodyList_Copy(list, length, i);
+        }
+
+        remap[i] = length++;
+    }
+
+    int removed = list->length - length;
+    list->length = length;
+
+    return removed;
+}
 
 void BodyList_Destroy(BodyList *list)
 {
@@ -360,11 +706,163 @@ void BodyList_Destroy(BodyList *list)
     {
         for (int i = 0; i < list->length; ++i)
         {
-            Body_Destroy(&list->bodies[i]);
+            Body_Destroy(&list->bodies[i], list->library);
         }
 
-        list->length = 0;
-        free(list->bodies);
-        list->bodies = NULL;
+        Alloc_Free(list->bodies);
     }
+
+    Alloc_Free(list->positionX);
+    Alloc_Free(list->positionY);
+    Alloc_Free(list->velocityX);
+    Alloc_Free(list->velocityY);
+    Alloc_Free(list->invMass);
+    Alloc_Free(list->resistituion);
+    Alloc_Free(list->awake);
+    Alloc_Free(list->sleepTime);
+    Alloc_Free(list->previousX);
+    Alloc_Free(list->previousY);
+    Alloc_Free(list->vertices);
+    Alloc_Free(list->normals);
+    Alloc_Free(list->centroids);
+
+    Alloc_Free(list->slots);
+    Alloc_Free(list->slotIndex);
+    Alloc_Free(list->slotGeneration);
+
+    BodyList_Create(list, list->library);
+}
+
+int BodyList_GetIndex(BodyList *list, BodyHandle handle)
+{
+    if (handle.slot < 0 || handle.slot >= list->slotLength || 
+        list->slotGeneration[handle.slot] != handle.generation)
+    {
+        return -1;
+    }
+
+    return list->slotIndex[handle.slot];
+}
+
+BodyHandle BodyList_GetHandle(BodyList *list, int index)
+{
+    int slot = list->slots[index];
+    BodyHandle handle = {slot, list->slotGeneration[slot]};
+
+    return handle;
+}
+
+void BodyList_Get(BodyList *list, int index, Body *body)
+{
+    (*body) = list->bodies[index];
+
+    Vector2_Set(&body->position, list->positionX[index], list->positionY[index]);
+    Vector2_Set(&body->linearVelocity, list->velocityX[index], list->velocityY[index]);
+    body->invMass = list->invMass[index];
+    body->resistituion = list->resistituion[index];
+    body->transformedVertices = BodyList_GetVertices(list, index);
+}
+
+void BodyList_Set(BodyList *list, int index, Body *body)
+{
+    list->positionX[index] = body->position[0];
+    list->positionY[index] = body->position[1];
+    list->velocityX[index] = body->linearVelocity[0];
+    list->velocityY[index] = body->linearVelocity[1];
+    list->invMass[index] = body->invMass;
+    list->resistituion[index] = body->resistituion;
+
+    BodyList_Wake(list, index);
+}
+
+void BodyList_Move(BodyList *list, int index, Vector2 amount)
+{
+    BodyList_Translate(list, index, amount);
+    BodyList_Wake(list, index);
+}
+
+/* BodyList_Move for the solver, resting contacts are corrected every substep and must not wake */
+void BodyList_Translate(BodyList *list, int index, Vector2 amount)
+{
+    list->positionX[index] = list->positionX[index] + amount[0];
+    list->positionY[index] = list->positionY[index] + amount[1];
+
+    BodyList_UpdateBox(list, index);
+}
+
+void BodyList_AddForce(BodyList *list, int index, Vector2 amount)
+{
+    Body_AddForce(&list->bodies[index], amount);
+    BodyList_Wake(list, index);
+}
+
+void BodyList_Wake(BodyList *list, int index)
+{
+    list->awake[index] = 1.0f;
+    list->sleepTime[index] = 0.0f;
+}
+
+bool BodyList_IsAwake(BodyList *list, int index)
+{
+    return list->awake[index] != 0.0f;
+}
+
+void BodyList_SavePositions(BodyList *list)
+{
+    if (list->length == 0)
+    {
+        return;
+    }
+
+    memcpy(list->previousX, list->positionX, list->length * sizeof(float));
+    memcpy(list->previousY, list->positionY, list->length * sizeof(float));
+}
+
+/* alpha 0 is the position before the last step, 1 the current one */
+void BodyList_GetInterpolated(BodyList *list, int index, float alpha, Vector2 *position)
+{
+    (*position)[0] = list->previousX[index] + (list->positionX[index] - list->previousX[index]) * alpha;
+    (*position)[1] = list->previousY[index] + (list->positionY[index] - list->previousY[index]) * alpha;
+}
+
+/*
+    Refreshes everything the narrow-phase reads from a box or polygon: vertices,
+    edge normals and centroid all come out of the same transform. Normals only rotate.
+*/
+void BodyList_UpdateBox(BodyList *list, int index)
+{
+    Body *box = &list->bodies[index];
+
+    if (box->shape != Circle)
+    {
+        ShapeLibrary *library = list->library;
+        Shape *shape = ShapeLibrary_Get(library, box->shapeId);
+
+        Transform transform;
+        Transform_Set(&transform, list->positionX[index], list->positionY[index], box->rotation);
+
+        Body_TransformVertices(BodyList_GetVertices(list, index), ShapeLibrary_GetVertices(library, box->shapeId), 
+                            box->vertLength, transform);
+        Vector2_Transformv(&list->centroids[index], shape->centroid, transform);
+
+        Vector2_SetZero(&transform[0]);
+        Body_TransformVertices(BodyList_GetNormals(list, index), ShapeLibrary_GetNormals(library, box->shapeId), 
+                            box->vertLength, transform);
+    }
+}
+
+void BodyList_GetAABB(BodyList *list, int index)
+{
+    Body_ComputeAABB(&list->bodies[index], BodyList_GetVertices(list, index), 
+                    list->positionX[index], list->positionY[index]);
+}
+
+Vector2 *BodyList_GetVertices(BodyList *list, int index)
+{
+    return &list->vertices[index * SHAPE_MAX_VERTICES];
+}
+
+Vector2 *BodyList_GetNormals(BodyList *list, int index)
+{
+    return &list->normals[index * SHAPE_MAX_VERTICES];
 }
\ No newline at end of file
@@ -2,45 +2,61 @@
 #define _BODY_H_
 
 #include "types.h"
+#include "shape.h"
 #include <stdbool.h>
 
-typedef struct Window                   Window;
-typedef struct Color                    Color;
 typedef struct World                    World;
 
 typedef struct Body                     Body;
 typedef struct BodyList                 BodyList;
-typedef enum   ShapeType                ShapeType;
+typedef struct BodyHandle               BodyHandle;
 
 #define PI 3.14159265358979323846264338327950288
 
-bool Body_NewBox(Body *body, Vector2 position, float width, float height, float mass, 
-                float rotation, float resistituion, bool isStatic);
+/* Body_NewPolygon sorts and hulls its points on the stack, at most this many */
+#define BODY_MAX_POLYGON_POINTS 64
+
+bool Body_NewBox(Body *body, ShapeLibrary *library, Vector2 position, float width, float height, 
+                float mass, float rotation, float resistituion, bool isStatic);
 
-bool Body_NewCircle(Body *body, Vector2 center, float radius, float density, 
+bool Body_NewCircle(Body *body, ShapeLibrary *library, Vector2 center, float radius, float density, 
                 float rotation, float resistituion, bool isStatic);
 
+bool Body_NewPolygon(Body *body, ShapeLibrary *library, Vector2 position, Vector2 *points, int length, 
+                float mass, float rotation, float resistituion, bool isStatic);
+
 void Body_AddForce(Body *body, Vector2 amount);
-void Body_Debug(Body *body, Window *window, Color color);
-void Body_Step(Body *body, World *world, int interations, float time);
-void Body_Move(Body *body, Vector2 amount);
-void Body_UpdateBox(Body *box);
+void Body_Step(BodyList *list, World *world, int interations, float time);
+void Body_Move(Body *body, ShapeLibrary *library, Vector2 amount);
+void Body_UpdateBox(Body *box, ShapeLibrary *library);
 
 void Body_GetAABB(Body *body);
 
-void Body_Destroy(Body *body);
+void Body_Destroy(Body *body, ShapeLibrary *library);
 
-void BodyList_Create(BodyList *list);
-void BodyList_Push(BodyList *list, Body *body);
+void BodyList_Create(BodyList *list, ShapeLibrary *library);
+bool BodyList_Reserve(BodyList *list, int capacity);
+BodyHandle BodyList_Push(BodyList *list, Body *body);
 void BodyList_Remove(BodyList *list, int index);
+int BodyList_Compact(BodyList *list, int *remap);
 void BodyList_Destroy(BodyList *list);
 
-enum ShapeType 
-{
-    Box,
-    Circle,
-    Polygon
-};
+int BodyList_GetIndex(BodyList *list, BodyHandle handle);
+BodyHandle BodyList_GetHandle(BodyList *list, int index);
+
+void BodyList_Get(BodyList *list, int index, Body *body);
+void BodyList_Set(BodyList *list, int index, Body *body);
+void BodyList_Move(BodyList *list, int index, Vector2 amount);
+void BodyList_Translate(BodyList *list, int index, Vector2 amount);
+void BodyList_AddForce(BodyList *list, int index, Vector2 amount);
+void BodyList_Wake(BodyList *list, int index);
+bool BodyList_IsAwake(BodyList *list, int index);
+void BodyList_SavePositions(BodyList *list);
+void BodyList_GetInterpolated(BodyList *list, int index, float alpha, Vector2 *position);
+void BodyList_UpdateBox(BodyList *list, int index);
+void BodyList_GetAABB(BodyList *list, int index);
+Vector2 *BodyList_GetVertices(BodyList *list, int index);
+Vector2 *BodyList_GetNormals(BodyList *list, int index);
 
 struct Body
 {
@@ -60,20 +76,73 @@ struct Body
     float rotation;
     float rotationVelocity;
 
-    Vector2 *vertices;
+    int shapeId;
     Vector2 *transformedVertices;
     int vertLength;
+    float boundingRadius;
 
     AABB aabb;
 
     ShapeType shape;
     bool isStatic;
+    bool isDead;
 };
 
+/*
+    Stable reference to a body, survives the swaps of BodyList_Remove. The
+    generation is bumped whenever the slot is freed so stale handles resolve to -1.
+*/
+struct BodyHandle
+{
+    int slot;
+    Uint32 generation;
+};
+
+/*
+    Structure of arrays, the hot per-body state integrated and solved every substep
+    lives in its own contiguous array. bodies[] keeps the cold data (shape, extents,
+    aabb); its position, linearVelocity, invMass, resistituion and transformedVertices
+    fields are not kept up to date, use BodyList_Get/BodyList_Set for a full Body view.
+    World-space vertices of body i sit in vertices[i * SHAPE_MAX_VERTICES], the local
+    geometry is shared through library. normals (same stride) and centroids cache the
+    world-space edge normals and center of boxes, refreshed with their vertices;
+    circles use their position as center.
+    awake is 1.0f or 0.0f so the integration kernel can mask on it like on invMass;
+    sleepTime is how long the body has been resting. Sleeping bodies are not
+    integrated; BodyList_Set, BodyList_Move and BodyList_AddForce wake them.
+    previousX/Y hold the positions before the last fixed step (BodyList_SavePositions)
+    so rendering can interpolate between two steps.
+    Removal swaps the last body into the hole, so indices are not stable; slots[i] is the
+    handle slot of body i and slotIndex maps a slot back to its index (or to the next
+    free slot). Bodies marked isDead are dropped together by BodyList_Compact. Storage only grows, doubling from 64.
+*/
 struct BodyList
 {
+    float *positionX;
+    float *positionY;
+    float *velocityX;
+    float *velocityY;
+    float *invMass;
+    float *resistituion;
+    float *awake;
+    float *sleepTime;
+    float *previousX;
+    float *previousY;
+    Vector2 *vertices;
+    Vector2 *normals;
+    Vector2 *centroids;
+
+    int *slots;
+    int *slotIndex;
+    Uint32 *slotGeneration;
+    int slotLength;
+    int freeSlot;
+
+    ShapeLibrary *library;
+
     Body *bodies;
     int length;
+    int capacity;
 };
 
 #endif
\ No newline at end of file
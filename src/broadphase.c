@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "broadphase.h"
+#include "body.h"
+#include "alloc.h"
+
+void PairList_Create(PairList *list)
+{
+    list->pairs = NULL;
+    list->length = 0;
+    list->capacity = 0;
+}
+
+void PairList_Push(PairList *list, int a, int b)
+{
+    if (list->length == list->capacity)
+    {
+        int capacity = (list->capacity > 0) ? list->capacity * 2 : 64;
+        BodyPair *temp = (BodyPair *)Alloc_Realloc(list->pairs, capacity * sizeof(BodyPair));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the pair list.\n");
+            return;
+        }
+
+        list->pairs = temp;
+        list->capacity = capacity;
+    }
+
+    BodyPair pair = {a, b};
+    list->pairs[list->length++] = pair;
+}
+
+void PairList_Clear(PairList *list)
+{
+    list->length = 0;
+}
+
+void PairList_Destroy(PairList *list)
+{
+    if (list->pairs != NULL)
+    {
+        Alloc_Free(list->pairs);
+    }
+
+    list->pairs = NULL;
+    list->length = 0;
+    list->capacity = 0;
+}
+
+static void AllPairs_FindPairs(void *context, BodyList *bodies, PairList *pairs)
+{
+    (void)context;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        for (int j = i + 1; j < bodies->length; ++j)
+        {
+            if (bodies->bodies[i].isStatic && bodies->bodies[j].isStatic)
+            {
+                continue;
+            }
+
+            PairList_Push(pairs, i, j);
+        }
+    }
+}
+
+static void Grid_Reserve(void *context, int capacity)
+{
+    SpatialGrid_Reserve((SpatialGrid *)context, capacity);
+}
+
+static void Grid_Update(void *context, BodyList *bodies)
+{
+    SpatialGrid_Build((SpatialGrid *)context, bodies);
+}
+
+static void Grid_FindPairs(void *context, BodyList *bodies, PairList *pairs)
+{
+    SpatialGrid_FindPairs((SpatialGrid *)context, bodies, pairs);
+}
+
+static void Grid_Destroy(void *context)
+{
+    SpatialGrid_Destroy((SpatialGrid *)context);
+    Alloc_Free(context);
+}
+
+static void Tree_Insert(void *context, BodyList *bodies, int index)
+{
+    DynamicTree_Insert((DynamicTree *)context, bodies, index);
+}
+
+static void Tree_Remove(void *context, BodyList *bodies, int index)
+{
+    DynamicTree_Remove((DynamicTree *)context, bodies, index);
+}
+
+static void Tree_Compact(void *context, const int *remap, int length)
+{
+    DynamicTree_Compact((DynamicTree *)context, remap, length);
+}
+
+static void Tree_Reserve(void *context, int capacity)
+{
+    DynamicTree_Reserve((DynamicTree *)context, capacity);
+}
+
+static void Tree_Update(void *context, BodyList *bodies)
+{
+    DynamicTree_Update((DynamicTree *)context, bodies);
+}
+
+static void Tree_FindPairs(void *context, BodyList *bodies, PairList *pairs)
+{
+    DynamicTree_FindPairs((DynamicTree *)context, bodies, pairs);
+}
+
+static void Tree_Destroy(void *context)
+{
+    DynamicTree_Destroy((DynamicTree *)context);
+    Alloc_Free(context);
+}
+
+static void Sweep_Insert(void *context, BodyList *bodies, int index)
+{
+    SweepAndPrune_Insert((SweepAndPrune *)context, bodies, index);
+}
+
+static void Sweep_Remove(void *context, BodyList *bodies, int index)
+{
+    SweepAndPrune_Remove((SweepAndPrune *)context, bodies, index);
+}
+
+static void Sweep_Compact(void *context, const int *remap, int length)
+{
+    SweepAndPrune_Compact((SweepAndPrune *)context, remap, length);
+}
+
+static void Sweep_Reserve(void *context, int capacity)
+{
+    SweepAndPrune_Reserve((SweepAndPrune *)context, capacity);
+}
+
+static void Sweep_Update(void *context, BodyList *bodies)
+{
+    SweepAndPrune_Update((SweepAndPrune *)context, bodies);
+}
+
+static void Sweep_FindPairs(void *context, BodyList *bodies, PairList *pairs)
+{
+    SweepAndPrune_FindPairs((SweepAndPrune *)context, bodies, pairs);
+}
+
+static void Sweep_Destroy(void *context)
+{
+    SweepAndPrune_Destroy((SweepAndPrune *)context);
+    Alloc_Free(context);
+}
+
+void BroadPhase_Create(BroadPhase *broadPhase, BroadPhaseType type)
+{
+    broadPhase->type = type;
+    broadPhase->context = NULL;
+
+    broadPhase->insert = NULL;
+    broadPhase->remove = NULL;
+    broadPhase->compact = NULL;
+    broadPhase->reserve = NULL;
+    broadPhase->update = NULL;
+    broadPhase->findPairs = NULL;
+    broadPhase->destroy = NULL;
+
+    switch (type)
+    {
+        case BroadPhase_AllPairs:
+            broadPhase->findPairs = AllPairs_FindPairs;
+        break;
+
+        case BroadPhase_Grid:
+            broadPhase->context = Alloc_Malloc(sizeof(SpatialGrid));
+
+            if (broadPhase->context == NULL)
+            {
+                printf("Error when creating the grid broad-phase.\n");
+                return;
+            }
+
+            SpatialGrid_Create((SpatialGrid *)broadPhase->context, GRID_DEFAULT_CELL_SIZE);
+
+            broadPhase->reserve = Grid_Reserve;
+            broadPhase->update = Grid_Update;
+            broadPhase->findPairs = Grid_FindPairs;
+            broadPhase->destroy = Grid_Destroy;
+        break;
+
+        case BroadPhase_Tree:
+            broadPhase->context = Alloc_Malloc(sizeof(DynamicTree));
+
+            if (broadPhase->context == NULL)
+            {
+                printf("Error when creating the tree broad-phase.\n");
+                return;
+            }
+
+            DynamicTree_Create((DynamicTree *)broadPhase->context);
+
+            broadPhase->insert = Tree_Insert;
+            broadPhase->remove = Tree_Remove;
+            broadPhase->compact = Tree_Compact;
+            broadPhase->reserve = Tree_Reserve;
+            broadPhase->update = Tree_Update;
+            broadPhase->findPairs = Tree_FindPairs;
+            broadPhase->destroy = Tree_Destroy;
+        break;
+
+        case BroadPhase_SweepAndPrune:
+            broadPhase->context = Alloc_Malloc(sizeof(SweepAndPrune));
+
+            if (broadPhase->context == NULL)
+            {
+                printf("Error when creating the sweep-and-prune broad-phase.\n");
+                return;
+            }
+
+            SweepAndPrune_Create((SweepAndPrune *)broadPhase->context);
+
+            broadPhase->insert = Sweep_Insert;
+            broadPhase->remove = Sweep_Remove;
+            broadPhase->compact = Sweep_Compact;
+            broadPhase->reserve = Sweep_Reserve;
+            broadPhase->update = Sweep_Update;
+            broadPhase->findPairs = Sweep_FindPairs;
+            broadPhase->destroy = Sweep_Destroy;
+        break;
+
+        default:
+        break;
+    }
+}
+
+void BroadPhase_Insert(BroadPhase *broadPhase, BodyList *bodies, int index)
+{
+    if (broadPhase->insert != NULL)
+    {
+        broadPhase->insert(broadPhase->context, bodies, index);
+    }
+}
+
+void BroadPhase_Remove(BroadPhase *broadPhase, BodyList *bodies, int index)
+{
+    if (broadPhase->remove != NULL)
+    {
+        broadPhase->remove(broadPhase->context, bodies, index);
+    }
+}
+
+void BroadPhase_Compact(BroadPhase *broadPhase, const int *remap, int length)
+{
+    if (broadPhase->compact != NULL)
+    {
+        broadPhase->compact(broadPhase->context, remap, length);
+    }
+}
+
+void BroadPhase_Reserve(BroadPhase *broadPhase, int capacity)
+{
+    if (broadPhase->reserve != NULL)
+    {
+        broadPhase->reserve(broadPhase->context, capacity);
+    }
+}
+
+void BroadPhase_Update(BroadPhase *broadPhase, BodyList *bodies)
+{
+    if (broadPhase->update != NULL)
+    {
+        broadPhase->update(broadPhase->context, bodies);
+    }
+}
+
+void BroadPhase_FindPairs(BroadPhase *broadPhase, BodyList *bodies, PairList *pairs)
+{
+    if (broadPhase->findPairs != NULL)
+    {
+        broadPhase->findPairs(broadPhase->context, bodies, pairs);
+    }
+}
+
+void BroadPhase_Destroy(BroadPhase *broadPhase)
+{
+    if (broadPhase->destroy != NULL)
+    {
+        broadPhase->destroy(broadPhase->context);
+    }
+
+    broadPhase->context = NULL;
+}
+
+const char *BroadPhase_Name(BroadPhaseType type)
+{
+    switch (type)
+    {
+        case BroadPhase_AllPairs: return "All Pairs";
+        case BroadPhase_Grid: return "Grid";
+        case BroadPhase_Tree: return "Tree";
+        case BroadPhase_SweepAndPrune: return "Sweep and Prune";
+        default: return "Unknown";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#ifndef _BROADPHASE_H_
+#define _BROADPHASE_H_
+
+#include "types.h"
+#include <stdbool.h>
+
+typedef struct BodyList                 BodyList;
+
+typedef struct BodyPair                 BodyPair;
+typedef struct PairList                 PairList;
+
+typedef struct BroadPhase               BroadPhase;
+typedef enum   BroadPhaseType           BroadPhaseType;
+
+typedef struct GridEntry                GridEntry;
+typedef struct SpatialGrid              SpatialGrid;
+
+typedef struct TreeNode                 TreeNode;
+typedef struct DynamicTree              DynamicTree;
+
+typedef struct SweepEndpoint            SweepEndpoint;
+typedef struct SweepAndPrune            SweepAndPrune;
+
+#define GRID_DEFAULT_CELL_SIZE  64.0f
+#define GRID_MAX_BODY_CELLS     16
+#define GRID_RESERVE_BODY_CELLS 4
+
+#define TREE_NULL_NODE          -1
+#define TREE_AABB_MARGIN        8.0f
+
+void PairList_Create(PairList *list);
+void PairList_Push(PairList *list, int a, int b);
+void PairList_Clear(PairList *list);
+void PairList_Destroy(PairList *list);
+
+void BroadPhase_Create(BroadPhase *broadPhase, BroadPhaseType type);
+void BroadPhase_Insert(BroadPhase *broadPhase, BodyList *bodies, int index);
+void BroadPhase_Remove(BroadPhase *broadPhase, BodyList *bodies, int index);
+void BroadPhase_Compact(BroadPhase *broadPhase, const int *remap, int length);
+void BroadPhase_Reserve(BroadPhase *broadPhase, int capacity);
+void BroadPhase_Update(BroadPhase *broadPhase, BodyList *bodies);
+void BroadPhase_FindPairs(BroadPhase *broadPhase, BodyList *bodies, PairList *pairs);
+void BroadPhase_Destroy(BroadPhase *broadPhase);
+const char *BroadPhase_Name(BroadPhaseType type);
+
+void SpatialGrid_Create(SpatialGrid *grid, float cellSize);
+void SpatialGrid_Reserve(SpatialGrid *grid, int capacity);
+void SpatialGrid_Build(SpatialGrid *grid, BodyList *bodies);
+void SpatialGrid_FindPairs(SpatialGrid *grid, BodyList *bodies, PairList *pairs);
+void SpatialGrid_Destroy(SpatialGrid *grid);
+
+void DynamicTree_Create(DynamicTree *tree);
+void DynamicTree_Insert(DynamicTree *tree, BodyList *bodies, int index);
+void DynamicTree_Remove(DynamicTree *tree, BodyList *bodies, int index);
+void DynamicTree_Compact(DynamicTree *tree, const int *remap, int length);
+void DynamicTree_Reserve(DynamicTree *tree, int capacity);
+void DynamicTree_Update(DynamicTree *tree, BodyList *bodies);
+void DynamicTree_FindPairs(DynamicTree *tree, BodyList *bodies, PairList *pairs);
+void DynamicTree_Destroy(DynamicTree *tree);
+
+void SweepAndPrune_Create(SweepAndPrune *sap);
+void SweepAndPrune_Insert(SweepAndPrune *sap, BodyList *bodies, int index);
+void SweepAndPrune_Remove(SweepAndPrune *sap, BodyList *bodies, int index);
+void SweepAndPrune_Compact(SweepAndPrune *sap, const int *remap, int length);
+void SweepAndPrune_Reserve(SweepAndPrune *sap, int capacity);
+void SweepAndPrune_Update(SweepAndPrune *sap, BodyList *bodies);
+void SweepAndPrune_FindPairs(SweepAndPrune *sap, BodyList *bodies, PairList *pairs);
+void SweepAndPrune_Destroy(SweepAndPrune *sap);
+
+enum BroadPhaseType
+{
+    BroadPhase_AllPairs,
+    BroadPhase_Grid,
+    BroadPhase_Tree,
+    BroadPhase_SweepAndPrune,
+    BroadPhase_Count
+};
+
+struct BodyPair
+{
+    int a;
+    int b;
+};
+
+struct PairList
+{
+    BodyPair *pairs;
+    int length;
+    int capacity;
+};
+
+/*
+    Every broad-phase sits behind the same set of callbacks, World only talks
+    to it through the BroadPhase_* functions. insert/remove are called as bodies
+    enter and leave the BodyList (remove before the last body is swapped into the
+    hole), compact after BodyList_Compact with the remap of its length old indices,
+    reserve preallocates for a body count, update once per substep after
+    the AABBs are refreshed, and findPairs emits each candidate pair once.
+*/
+struct BroadPhase
+{
+    BroadPhaseType type;
+    void *context;
+
+    void (*insert)(void *context, BodyList *bodies, int index);
+    void (*remove)(void *context, BodyList *bodies, int index);
+    void (*compact)(void *context, const int *remap, int length);
+    void (*reserve)(void *context, int capacity);
+    void (*update)(void *context, BodyList *bodies);
+    void (*findPairs)(void *context, BodyList *bodies, PairList *pairs);
+    void (*destroy)(void *context);
+};
+
+struct GridEntry
+{
+    int body;
+    int cellX;
+    int cellY;
+    Uint32 hash;
+};
+
+/*
+    Uniform grid hashed into a fixed bucket table. Bodies are binned by their AABB
+    every build; anything covering more than GRID_MAX_BODY_CELLS cells (the ground box)
+    is kept out of the table and tested against the other bodies directly.
+*/
+struct SpatialGrid
+{
+    float cellSize;
+    float invCellSize;
+
+    GridEntry *entries;
+    GridEntry *sorted;
+    int entryLength;
+    int entryCapacity;
+
+    int *bucketStart;
+    int bucketCount;
+
+    int *large;
+    int largeLength;
+    int largeCapacity;
+};
+
+struct TreeNode
+{
+    AABB aabb;
+
+    int parent;
+    int child0;
+    int child1;
+    int height;
+
+    int body;
+};
+
+/*
+    Dynamic AABB tree, leaves hold the body AABB fattened by TREE_AABB_MARGIN and
+    are only reinserted once the body leaves it. leaves[] maps a body index to its leaf.
+*/
+struct DynamicTree
+{
+    TreeNode *nodes;
+    int nodeCapacity;
+    int freeList;
+    int root;
+
+    int *leaves;
+    int leafCapacity;
+
+    int *stack;
+    int stackCapacity;
+};
+
+struct SweepEndpoint
+{
+    float value;
+    int body;
+    bool isMax;
+};
+
+/*
+    Persistent sweep-and-prune. Min/max endpoints on both axes stay sorted
+    between steps and are re-sorted with insertion sort, every swap of a min past
+    a max is a pair add/remove event. The overlapping pairs are kept in an open
+    addressing set (keys/slots) backing the dense pairs list.
+*/
+struct SweepAndPrune
+{
+    SweepEndpoint *axis[2];
+    int endpointLength;
+    int endpointCapacity;
+
+    Uint64 *keys;
+    int *slots;
+    int keyCapacity;
+
+    BodyPair *pairs;
+    int pairLength;
+    int pairCapacity;
+
+    int addedPairs;
+    int removedPairs;
+};
+
+#endif
\ No newline at end of file
@@ -1,7 +1,10 @@
+#include <float.h>
+#include <math.h>
 #include "collision.h"
-#include <SDL2/SDL.h>
+#include "shape.h"
+#include "simd.h"
 
-bool IntersectPolygon(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
+bool IntersectPolygonScalar(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
                     Vector2 *normal, float *depth)
 {
     *depth = FLT_MAX;
@@ -29,7 +32,7 @@ bool IntersectPolygon(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int l
             return false;
         }
 
-        float axisDepth = SDL_min(maxA - minB, maxB - minA);
+        float axisDepth = fminf(maxA - minB, maxB - minA);
 
         if (axisDepth < *depth)
         {
@@ -60,7 +63,7 @@ bool IntersectPolygon(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int l
             return false;
         }
 
-        float axisDepth = SDL_min(maxA - minB, maxB - minA);
+        float axisDepth = fminf(maxA - minB, maxB - minA);
 
         if (axisDepth < *depth)
         {
@@ -84,6 +87,164 @@ bool IntersectPolygon(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int l
     return true;
 }
 
+static void Collision_OrientNormal(Vector2 centerA, Vector2 centerB, Vector2 *normal)
+{
+    Vector2 direction;
+    Vector2_Sub(&direction, centerB, centerA);
+
+    if (Vector2_Dot(direction, *normal) < 0.0f)
+    {
+        Vector2_Multl(normal, -1.0f);
+    }
+}
+
+#if defined(SIMD_SSE2)
+
+static __m128 Collision_Project(Vector2 *vertices, int length, __m128 axisX, __m128 axisY, __m128 *max)
+{
+    __m128 x = _mm_set1_ps(vertices[0][0]);
+    __m128 y = _mm_set1_ps(vertices[0][1]);
+    __m128 min = _mm_add_ps(_mm_mul_ps(x, axisX), _mm_mul_ps(y, axisY));
+
+    *max = min;
+
+    for (int i = 1; i < length; ++i)
+    {
+        x = _mm_set1_ps(vertices[i][0]);
+        y = _mm_set1_ps(vertices[i][1]);
+
+        __m128 projection = _mm_add_ps(_mm_mul_ps(x, axisX), _mm_mul_ps(y, axisY));
+
+        min = _mm_min_ps(min, projection);
+        *max = _mm_max_ps(*max, projection);
+    }
+
+    return min;
+}
+
+/*
+    SAT over 4 axes per pass. The cached unit edge normals of both polygons are
+    gathered and padded by repeating the last one. Both polygons are projected on
+    the 4 axes at once and the first pass holding a separating axis returns.
+*/
+bool IntersectPolygon(Vector2 *verticesA, Vector2 *normalsA, int lengthA, Vector2 centerA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, Vector2 centerB, 
+                    Vector2 *normal, float *depth)
+{
+    float axesX[SHAPE_MAX_VERTICES * 2 + 3];
+    float axesY[SHAPE_MAX_VERTICES * 2 + 3];
+    int axisLength = 0;
+
+    for (int i = 0; i < lengthA; ++i)
+    {
+        axesX[axisLength] = normalsA[i][0];
+        axesY[axisLength] = normalsA[i][1];
+        axisLength++;
+    }
+
+    for (int i = 0; i < lengthB; ++i)
+    {
+        axesX[axisLength] = normalsB[i][0];
+        axesY[axisLength] = normalsB[i][1];
+        axisLength++;
+    }
+
+    for (int i = axisLength; (i & 3) != 0; ++i)
+    {
+        axesX[i] = axesX[axisLength - 1];
+        axesY[i] = axesY[axisLength - 1];
+    }
+
+    float best = FLT_MAX;
+    int bestAxis = 0;
+
+    for (int a = 0; a < axisLength; a += 4)
+    {
+        __m128 axisX = _mm_loadu_ps(&axesX[a]);
+        __m128 axisY = _mm_loadu_ps(&axesY[a]);
+
+        __m128 maxA, maxB;
+        __m128 minA = Collision_Project(verticesA, lengthA, axisX, axisY, &maxA);
+        __m128 minB = Collision_Project(verticesB, lengthB, axisX, axisY, &maxB);
+
+        __m128 separated = _mm_or_ps(_mm_cmpgt_ps(minA, maxB), _mm_cmpgt_ps(minB, maxA));
+
+        if (_mm_movemask_ps(separated) != 0)
+        {
+            return false;
+        }
+
+        float axisDepth[4];
+        _mm_storeu_ps(axisDepth, _mm_min_ps(_mm_sub_ps(maxA, minB), _mm_sub_ps(maxB, minA)));
+
+        for (int i = 0; i < 4 && a + i < axisLength; ++i)
+        {
+            if (axisDepth[i] < best)
+            {
+                best = axisDepth[i];
+                bestAxis = a + i;
+            }
+        }
+    }
+
+    *depth = best;
+    Vector2_Set(normal, axesX[bestAxis], axesY[bestAxis]);
+
+    Collision_OrientNormal(centerA, centerB, normal);
+
+    return true;
+}
+
+#else
+
+static bool Collision_TestAxes(Vector2 *axes, int length, Vector2 *verticesA, int lengthA, 
+                            Vector2 *verticesB, int lengthB, Vector2 *normal, float *depth)
+{
+    for (int i = 0; i < length; ++i)
+    {
+        float minA, minB;
+        float maxA, maxB;
+
+        Vector2_Projection(verticesA, lengthA, axes[i], &minA, &maxA);
+        Vector2_Projection(verticesB, lengthB, axes[i], &minB, &maxB);
+
+        if (minA > maxB || minB > maxA)
+        {
+            return false;
+        }
+
+        float axisDepth = fminf(maxA - minB, maxB - minA);
+
+        if (axisDepth < *depth)
+        {
+            *depth = axisDepth;
+            Vector2_Setv(normal, axes[i]);
+        }
+    }
+
+    return true;
+}
+
+bool IntersectPolygon(Vector2 *verticesA, Vector2 *normalsA, int lengthA, Vector2 centerA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, Vector2 centerB, 
+                    Vector2 *normal, float *depth)
+{
+    *depth = FLT_MAX;
+    Vector2_SetZero(normal);
+
+    if (!Collision_TestAxes(normalsA, lengthA, verticesA, lengthA, verticesB, lengthB, normal, depth) ||
+        !Collision_TestAxes(normalsB, lengthB, verticesA, lengthA, verticesB, lengthB, normal, depth))
+    {
+        return false;
+    }
+
+    Collision_OrientNormal(centerA, centerB, normal);
+
+    return true;
+}
+
+#endif
+
 float PolygonGetArea(Vector2 *vertices, int length)
 {
     float sum = 0.0f;
@@ -144,8 +305,8 @@ bool IntersectCircle(Vector2 *centerA, int radiusA, Vector2 *centerB, int radius
     return true;
 }
 
-bool IntersectPolygonCircle(Vector2 *vertices, int length, Vector2 *center, float radius, 
-                    Vector2 *normal, float *depth)
+bool IntersectPolygonCircle(Vector2 *vertices, Vector2 *normals, int length, Vector2 polygonCenter, 
+                    Vector2 *center, float radius, Vector2 *normal, float *depth)
 {
     float axisDepth = FLT_MAX;
     *depth = FLT_MAX;
@@ -159,30 +320,20 @@ bool IntersectPolygonCircle(Vector2 *vertices, int length, Vector2 *center, floa
 
     for (int i = 0; i < length; ++i)
     {
-        Vector2 point0 = {vertices[i][0], vertices[i][1]};
-        Vector2 point1 = {vertices[(i + 1) % length][0], vertices[(i + 1) % length][1]};
-
-        Vector2 edge;
-        Vector2_Sub(&edge, point1, point0);
-
-        axis;
-        Vector2_Normal(&axis, edge);
-        Vector2_Normalizedl(&axis);
-
-        Vector2_Projection(vertices, length, axis, &min, &max);
-        Vector2_ProjectionCircle(center, radius, axis, &cmin, &cmax);
+        Vector2_Projection(vertices, length, normals[i], &min, &max);
+        Vector2_ProjectionCircle(center, radius, normals[i], &cmin, &cmax);
 
         if (min >= cmax || cmin >= max)
         {
             return false;
         }
 
-        axisDepth = SDL_min(max - cmin, cmax - min);
+        axisDepth = fminf(max - cmin, cmax - min);
 
         if (axisDepth < *depth)
         {
             *depth = axisDepth;
-            Vector2_Setv(normal, axis);
+            Vector2_Setv(normal, normals[i]);
         }
     }
 
@@ -202,7 +353,7 @@ bool IntersectPolygonCircle(Vector2 *vertices, int length, Vector2 *center, floa
         return false;
     }
 
-    axisDepth = SDL_min(max - cmin, cmax - min);
+    axisDepth = fminf(max - cmin, cmax - min);
 
     if (axisDepth < *depth)
     {
@@ -210,9 +361,6 @@ bool IntersectPolygonCircle(Vector2 *vertices, int length, Vector2 *center, floa
         Vector2_Setv(normal, axis);
     }
 
-    Vector2 polygonCenter;
-    PolygonGetCenter(&polygonCenter, vertices, length);
-
     Vector2 direction;
     Vector2_Sub(&direction, polygonCenter, center);
 
@@ -220,6 +368,497 @@ bool IntersectPolygonCircle(Vector2 *vertices, int length, Vector2 *center, floa
     {
         Vector2_Multl(normal, -1.0f);
     }
+
+    return true;
+}
+
+/* gap between the projections of A and B + offset on axis, flips axis to point from A to B */
+static float Collision_AxisGap(Vector2 *verticesA, int lengthA, float radiusA, 
+                            Vector2 *verticesB, int lengthB, float radiusB, 
+                            Vector2 offset, Vector2 *axis)
+{
+    float minA, maxA, minB, maxB;
+
+    Vector2_Projection(verticesA, lengthA, *axis, &minA, &maxA);
+    Vector2_Projection(verticesB, lengthB, *axis, &minB, &maxB);
+
+    float shift = Vector2_Dot(offset, *axis);
+
+    minA -= radiusA;
+    maxA += radiusA;
+    minB += shift - radiusB;
+    maxB += shift + radiusB;
+
+    if (minA - maxB > minB - maxA)
+    {
+        Vector2_Multl(axis, -1.0f);
+        return minA - maxB;
+    }
+
+    return minB - maxA;
+}
+
+/*
+    Largest gap between two convex shapes over the separating axes, negative when they
+    overlap. A circle is one vertex (its center) with a radius and no normals (NULL).
+    B is shifted by offset. The gap never exceeds the true distance, which is what
+    conservative advancement needs. axis comes out pointing from A to B.
+*/
+float SeparationConvex(Vector2 *verticesA, Vector2 *normalsA, int lengthA, float radiusA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, float radiusB, 
+                    Vector2 offset, Vector2 *axis)
+{
+    float separation = -FLT_MAX;
+    Vector2 candidate;
+
+    for (int i = 0; normalsA != NULL && i < lengthA; ++i)
+    {
+        Vector2_Setv(&candidate, normalsA[i]);
+        float gap = Collision_AxisGap(verticesA, lengthA, radiusA, verticesB, lengthB, radiusB, offset, &candidate);
+
+        if (gap > separation)
+        {
+            separation = gap;
+            Vector2_Setv(axis, candidate);
+        }
+    }
+
+    for (int i = 0; normalsB != NULL && i < lengthB; ++i)
+    {
+        Vector2_Setv(&candidate, normalsB[i]);
+        float gap = Collision_AxisGap(verticesA, lengthA, radiusA, verticesB, lengthB, radiusB, offset, &candidate);
+
+        if (gap > separation)
+        {
+            separation = gap;
+            Vector2_Setv(axis, candidate);
+        }
+    }
+
+    /* a circle adds the axis from its center to the closest vertex of the other shape */
+    if (normalsA == NULL || normalsB == NULL)
+    {
+        Vector2 center, point;
+
+        if (normalsA == NULL)
+        {
+            Vector2_Sub(&center, verticesA[0], offset);
+            Vector2_Setv(&point, verticesB[FindClosestPointPolygon(center, verticesB, lengthB)]);
+        }
+        else
+        {
+            Vector2_Add(&point, verticesB[0], offset);
+            Vector2_Sub(&center, verticesA[FindClosestPointPolygon(point, verticesA, lengthA)], offset);
+            Vector2_Setv(&point, verticesB[0]);
+        }
+
+        Vector2_Sub(&candidate, point, center);
+
+        if (Vector2_LengthSquared(candidate) > 0.0f)
+        {
+            Vector2_Normalizedl(&candidate);
+            float gap = Collision_AxisGap(verticesA, lengthA, radiusA, verticesB, lengthB, radiusB, offset, &candidate);
+
+            if (gap > separation)
+            {
+                separation = gap;
+                Vector2_Setv(axis, candidate);
+            }
+        }
+    }
+
+    return separation;
+}
+
+/*
+    Vertex of B minus vertex of A farthest along direction, a support point of B - A.
+    The dot products are written out, this runs a few times per GJK iteration.
+*/
+static void Collision_Support(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
+                            Vector2 direction, Vector2 *result)
+{
+    float x = direction[0];
+    float y = direction[1];
+    int bestA = 0;
+    int bestB = 0;
+    float dotA = FLT_MAX;
+    float dotB = -FLT_MAX;
+
+    for (int i = 0; i < lengthA; ++i)
+    {
+        float dot = verticesA[i][0] * x + verticesA[i][1] * y;
+
+        if (dot < dotA)
+        {
+            dotA = dot;
+            bestA = i;
+        }
+    }
+
+    for (int i = 0; i < lengthB; ++i)
+    {
+        float dot = verticesB[i][0] * x + verticesB[i][1] * y;
+
+        if (dot > dotB)
+        {
+            dotB = dot;
+            bestB = i;
+        }
+    }
+
+    (*result)[0] = verticesB[bestB][0] - verticesA[bestA][0];
+    (*result)[1] = verticesB[bestB][1] - verticesA[bestA][1];
+}
+
+/*
+    Closest point of the simplex to the origin, the simplex reduced to the vertices
+    it lies on (Voronoi regions of the segment or triangle). Returns true when the
+    triangle contains the origin.
+*/
+static bool Collision_ReduceSimplex(Vector2 *simplex, int *count, Vector2 *closest)
+{
+    if (*count == 1)
+    {
+        Vector2_Setv(closest, simplex[0]);
+        return false;
+    }
+
+    Vector2 a, b, ab;
+    Vector2_Setv(&a, simplex[0]);
+    Vector2_Setv(&b, simplex[1]);
+    Vector2_Sub(&ab, b, a);
+
+    if (*count == 2)
+    {
+        float length = Vector2_LengthSquared(ab);
+        float t = (length > 0.0f) ? -Vector2_Dot(a, ab) / length : 0.0f;
+
+        if (t <= 0.0f)
+        {
+            *count = 1;
+            Vector2_Setv(closest, a);
+        }
+        else if (t >= 1.0f)
+        {
+            *count = 1;
+            Vector2_Setv(&simplex[0], b);
+            Vector2_Setv(closest, b);
+        }
+        else
+        {
+            Vector2_Set(closest, a[0] + ab[0] * t, a[1] + ab[1] * t);
+        }
+
+        return false;
+    }
+
+    Vector2 c, ac;
+    Vector2_Setv(&c, simplex[2]);
+    Vector2_Sub(&ac, c, a);
+
+    float d1 = -Vector2_Dot(ab, a);
+    float d2 = -Vector2_Dot(ac, a);
+
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+        *count = 1;
+        Vector2_Setv(closest, a);
+        return false;
+    }
+
+    float d3 = -Vector2_Dot(ab, b);
+    float d4 = -Vector2_Dot(ac, b);
+
+    if (d3 >= 0.0f && d4 <= d3)
+    {
+        *count = 1;
+        Vector2_Setv(&simplex[0], b);
+        Vector2_Setv(closest, b);
+        return false;
+    }
+
+    float vc = d1 * d4 - d3 * d2;
+
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        float t = d1 / (d1 - d3);
+
+        *count = 2;
+        Vector2_Set(closest, a[0] + ab[0] * t, a[1] + ab[1] * t);
+        return false;
+    }
+
+    float d5 = -Vector2_Dot(ab, c);
+    float d6 = -Vector2_Dot(ac, c);
+
+    if (d6 >= 0.0f && d5 <= d6)
+    {
+        *count = 1;
+        Vector2_Setv(&simplex[0], c);
+        Vector2_Setv(closest, c);
+        return false;
+    }
+
+    float vb = d5 * d2 - d1 * d6;
+
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        float t = d2 / (d2 - d6);
+
+        *count = 2;
+        Vector2_Setv(&simplex[1], c);
+        Vector2_Set(closest, a[0] + ac[0] * t, a[1] + ac[1] * t);
+        return false;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    {
+        float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+
+        *count = 2;
+        Vector2_Setv(&simplex[0], c);
+        Vector2_Set(closest, b[0] + (c[0] - b[0]) * t, b[1] + (c[1] - b[1]) * t);
+        return false;
+    }
+
+    Vector2_SetZero(closest);
+    return true;
+}
+
+static float Collision_TriangleArea(Vector2 a, Vector2 b, Vector2 c)
+{
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+/* grows a point or segment simplex that touches the origin into a triangle for EPA */
+static bool Collision_CompleteSimplex(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
+                                    Vector2 *simplex, int *count)
+{
+    Vector2 directions[4] = {{1.0f, 0.0f}, {-1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, -1.0f}};
+
+    for (int i = 0; *count == 1 && i < 4; ++i)
+    {
+        Collision_Support(verticesA, lengthA, verticesB, lengthB, directions[i], &simplex[1]);
+
+        Vector2 edge;
+        Vector2_Sub(&edge, simplex[1], simplex[0]);
+
+        if (Vector2_LengthSquared(edge) > COLLISION_GJK_EPSILON)
+        {
+            *count = 2;
+        }
+    }
+
+    if (*count < 2)
+    {
+        return false;
+    }
+
+    Vector2 edge, side;
+    Vector2_Sub(&edge, simplex[1], simplex[0]);
+    Vector2_Normal(&side, edge);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Collision_Support(verticesA, lengthA, verticesB, lengthB, side, &simplex[2]);
+
+        if (fabsf(Collision_TriangleArea(simplex[0], simplex[1], simplex[2])) > COLLISION_GJK_EPSILON)
+        {
+            *count = 3;
+            return true;
+        }
+
+        Vector2_Multl(&side, -1.0f);
+    }
+
+    return false;
+}
+
+/* outward normal and distance to the origin of the counter-clockwise edge a to b */
+static float Collision_EdgeDistance(Vector2 a, Vector2 b, Vector2 *normal)
+{
+    Vector2_Set(normal, b[1] - a[1], a[0] - b[0]);
+
+    if (Vector2_LengthSquared(*normal) <= 0.0f)
+    {
+        return FLT_MAX;
+    }
+
+    Vector2_Normalizedl(normal);
+
+    return Vector2_Dot(*normal, a);
+}
+
+/*
+    Expanding polytope: the triangle around the origin grows toward the edge of
+    B - A closest to the origin until the support point along its normal adds
+    less than COLLISION_EPA_TOLERANCE. That edge is the penetration, its outward
+    normal points from B to A. Edge i runs from vertex i to i + 1, an insertion
+    only recomputes the two edges it creates.
+*/
+static float Collision_ExpandPolytope(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
+                                    Vector2 *simplex, Vector2 *normal)
+{
+    Vector2 polytope[COLLISION_EPA_MAX_VERTICES];
+    Vector2 normals[COLLISION_EPA_MAX_VERTICES];
+    float distances[COLLISION_EPA_MAX_VERTICES];
+    int length = 3;
+
+    /* counter-clockwise, outward normals are then on the right of the edges */
+    bool clockwise = (Collision_TriangleArea(simplex[0], simplex[1], simplex[2]) < 0.0f);
+    Vector2_Setv(&polytope[0], simplex[0]);
+    Vector2_Setv(&polytope[1], simplex[clockwise ? 2 : 1]);
+    Vector2_Setv(&polytope[2], simplex[clockwise ? 1 : 2]);
+
+    for (int i = 0; i < length; ++i)
+    {
+        distances[i] = Collision_EdgeDistance(polytope[i], polytope[(i + 1) % length], &normals[i]);
+    }
+
+    int edge = 0;
+
+    for (int iteration = 0; iteration < COLLISION_EPA_ITERATIONS; ++iteration)
+    {
+        edge = 0;
+
+        for (int i = 1; i < length; ++i)
+        {
+            if (distances[i] < distances[edge])
+            {
+                edge = i;
+            }
+        }
+
+        Vector2 support;
+        Collision_Support(verticesA, lengthA, verticesB, lengthB, normals[edge], &support);
+
+        if (Vector2_Dot(support, normals[edge]) - distances[edge] < COLLISION_EPA_TOLERANCE || 
+            length == COLLISION_EPA_MAX_VERTICES)
+        {
+            break;
+        }
+
+        for (int i = length; i > edge + 1; --i)
+        {
+            Vector2_Setv(&polytope[i], polytope[i - 1]);
+            Vector2_Setv(&normals[i], normals[i - 1]);
+            distances[i] = distances[i - 1];
+        }
+
+        Vector2_Setv(&polytope[edge + 1], support);
+        length++;
+
+        int next = (edge + 2) % length;
+        distances[edge] = Collision_EdgeDistance(polytope[edge], polytope[edge + 1], &normals[edge]);
+        distances[edge + 1] = Collision_EdgeDistance(polytope[edge + 1], polytope[next], &normals[edge + 1]);
+    }
+
+    Vector2_Setv(normal, normals[edge]);
+
+    return distances[edge];
+}
+
+/*
+    GJK on support functions: only the vertices are read, so the cost grows with
+    the vertex count instead of edges times vertices like SAT. A circle is one vertex
+    (its center) with a radius, the vertices are the core shape and the radii are
+    added around it. While the cores are apart GJK gives their distance and direction,
+    once they overlap EPA finds the penetration. normal points from A to B like
+    IntersectPolygon, centers only pick the first search direction.
+*/
+bool IntersectConvexGJK(Vector2 *verticesA, int lengthA, float radiusA, Vector2 centerA, 
+                    Vector2 *verticesB, int lengthB, float radiusB, Vector2 centerB, 
+                    Vector2 *normal, float *depth)
+{
+    Vector2 simplex[3];
+    Vector2 closest;
+    Vector2 direction;
+    int count = 1;
+    bool enclosed = false;
+
+    Vector2_Sub(&direction, centerB, centerA);
+
+    if (Vector2_LengthSquared(direction) <= 0.0f)
+    {
+        Vector2_Set(&direction, 1.0f, 0.0f);
+    }
+
+    Collision_Support(verticesA, lengthA, verticesB, lengthB, direction, &simplex[0]);
+    Vector2_Setv(&closest, simplex[0]);
+
+    for (int iteration = 0; iteration < COLLISION_GJK_ITERATIONS; ++iteration)
+    {
+        float distance = Vector2_LengthSquared(closest);
+
+        if (distance <= COLLISION_GJK_EPSILON)
+        {
+            enclosed = true;
+            break;
+        }
+
+        Vector2 support;
+        Vector2_Set(&direction, -closest[0], -closest[1]);
+        Collision_Support(verticesA, lengthA, verticesB, lengthB, direction, &support);
+
+        /* no support point gets closer to the origin, closest is the distance */
+        if (distance - Vector2_Dot(support, closest) <= COLLISION_GJK_TOLERANCE * distance)
+        {
+            break;
+        }
+
+        Vector2_Setv(&simplex[count++], support);
+
+        if (Collision_ReduceSimplex(simplex, &count, &closest))
+        {
+            enclosed = true;
+            break;
+        }
+    }
+
+    float radius = radiusA + radiusB;
+
+    if (!enclosed)
+    {
+        float distance = Vector2_Length(closest);
+
+        if (distance > radius)
+        {
+            return false;
+        }
+
+        Vector2_Set(normal, closest[0] / distance, closest[1] / distance);
+        *depth = radius - distance;
+
+        return true;
+    }
+
+    /* cores touching in a point or along a segment have no area to expand */
+    if (count < 3 && !Collision_CompleteSimplex(verticesA, lengthA, verticesB, lengthB, simplex, &count))
+    {
+        if (radius <= 0.0f)
+        {
+            return false;
+        }
+
+        Vector2_Sub(normal, centerB, centerA);
+
+        if (Vector2_LengthSquared(*normal) <= 0.0f)
+        {
+            Vector2_Set(normal, 1.0f, 0.0f);
+        }
+
+        Vector2_Normalizedl(normal);
+        *depth = radius;
+
+        return true;
+    }
+
+    *depth = Collision_ExpandPolytope(verticesA, lengthA, verticesB, lengthB, simplex, normal) + radius;
+    Vector2_Multl(normal, -1.0f);
+
+    return true;
 }
 
 int FindClosestPointPolygon(Vector2 center, Vector2 *vertices, int length)
@@ -243,4 +882,133 @@ int FindClosestPointPolygon(Vector2 center, Vector2 *vertices, int length)
     }
 
     return index;
+}
+
+static int Collision_FindFace(Vector2 *normals, int length, Vector2 direction)
+{
+    int best = 0;
+    float bestDot = -FLT_MAX;
+
+    for (int i = 0; i < length; ++i)
+    {
+        float dot = Vector2_Dot(normals[i], direction);
+
+        if (dot > bestDot)
+        {
+            bestDot = dot;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/* keeps the part of segment in[0..1] where dot(axis, p) >= offset, returns the points left */
+static int Collision_Clip(Vector2 *in, Uint32 *inIds, Vector2 *out, Uint32 *outIds, Vector2 axis, float offset, Uint32 clipId)
+{
+    float distance0 = Vector2_Dot(axis, in[0]) - offset;
+    float distance1 = Vector2_Dot(axis, in[1]) - offset;
+    int count = 0;
+
+    if (distance0 >= 0.0f) { Vector2_Setv(&out[count], in[0]); outIds[count++] = inIds[0]; }
+    if (distance1 >= 0.0f) { Vector2_Setv(&out[count], in[1]); outIds[count++] = inIds[1]; }
+
+    if (distance0 * distance1 < 0.0f)
+    {
+        float t = distance0 / (distance0 - distance1);
+
+        Vector2_Set(&out[count], in[0][0] + (in[1][0] - in[0][0]) * t, in[0][1] + (in[1][1] - in[0][1]) * t);
+        outIds[count++] = clipId;
+    }
+
+    return count;
+}
+
+/*
+    Up to two points for a polygon pair that SAT found overlapping, normal pointing
+    from A to B. The reference face is the one most aligned with the normal, A's
+    facing B or B's facing A; the incident face of the other polygon is clipped to
+    its side planes and the points in front of it are dropped. Points lie on the
+    incident polygon. feature packs flip, reference edge, incident edge and which
+    end of the incident edge (or which side plane) the point came from.
+*/
+int FindContactPointsPolygon(Vector2 *verticesA, Vector2 *normalsA, int lengthA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, 
+                    Vector2 normal, ContactPoint *points)
+{
+    Vector2 reversed = {-normal[0], -normal[1]};
+
+    int faceA = Collision_FindFace(normalsA, lengthA, normal);
+    int faceB = Collision_FindFace(normalsB, lengthB, reversed);
+
+    Vector2 *reference = verticesA;
+    Vector2 *refNormals = normalsA;
+    Vector2 *incident = verticesB;
+    int refLength = lengthA;
+    int incLength = lengthB;
+    int refFace = faceA;
+    Uint32 flip = 0;
+
+    /* prefer A on ties so the choice does not flicker between substeps */
+    if (Vector2_Dot(normalsB[faceB], reversed) > Vector2_Dot(normalsA[faceA], normal) + 0.001f)
+    {
+        reference = verticesB;
+        refNormals = normalsB;
+        incident = verticesA;
+        refLength = lengthB;
+        incLength = lengthA;
+        refFace = faceB;
+        flip = 1;
+    }
+
+    Vector2 *refNormal = &refNormals[refFace];
+    Vector2 flipped = {-(*refNormal)[0], -(*refNormal)[1]};
+    int incFace = Collision_FindFace((flip) ? normalsA : normalsB, incLength, flipped);
+
+    Vector2 v1, v2;
+    Vector2_Setv(&v1, reference[refFace]);
+    Vector2_Setv(&v2, reference[(refFace + 1) % refLength]);
+
+    Vector2 tangent;
+    Vector2_Sub(&tangent, v2, v1);
+    Vector2_Normalizedl(&tangent);
+
+    Vector2 segment[2], clipped[2];
+    Uint32 ids[2] = {0, 1}, clippedIds[2];
+    Vector2_Setv(&segment[0], incident[incFace]);
+    Vector2_Setv(&segment[1], incident[(incFace + 1) % incLength]);
+
+    int count = Collision_Clip(segment, ids, clipped, clippedIds, tangent, Vector2_Dot(tangent, v1), 2);
+
+    if (count < 2)
+    {
+        return 0;
+    }
+
+    Vector2 back = {-tangent[0], -tangent[1]};
+    count = Collision_Clip(clipped, clippedIds, segment, ids, back, -Vector2_Dot(tangent, v2), 3);
+
+    if (count < 2)
+    {
+        return 0;
+    }
+
+    float front = Vector2_Dot(*refNormal, v1);
+    int length = 0;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        float separation = Vector2_Dot(*refNormal, segment[i]) - front;
+
+        if (separation <= 0.0f)
+        {
+            ContactPoint *point = &points[length++];
+
+            Vector2_Setv(&point->position, segment[i]);
+            point->depth = -separation;
+            point->feature = (flip << 24) | ((Uint32)refFace << 16) | ((Uint32)incFace << 8) | ids[i];
+        }
+    }
+
+    return length;
 }
\ No newline at end of file
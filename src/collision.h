@@ -2,18 +2,47 @@
 #define _COLLISION_H_
 
 #include "types.h"
+#include "contact.h"
 #include <stdbool.h>
 
-bool IntersectPolygon(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
+/*
+    GJK stops when the support point gets the distance closer by less than
+    COLLISION_GJK_TOLERANCE of it, EPA when the closest edge moves by less than
+    COLLISION_EPA_TOLERANCE pixels. The Minkowski difference of two 8 vertex
+    polygons has at most 16 vertices, the polytope never needs more room.
+*/
+#define COLLISION_GJK_ITERATIONS        32
+#define COLLISION_GJK_TOLERANCE         1e-4f
+#define COLLISION_GJK_EPSILON           1e-6f
+#define COLLISION_EPA_ITERATIONS        32
+#define COLLISION_EPA_TOLERANCE         1e-2f
+#define COLLISION_EPA_MAX_VERTICES      32
+
+bool IntersectPolygon(Vector2 *verticesA, Vector2 *normalsA, int lengthA, Vector2 centerA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, Vector2 centerB, 
                     Vector2 *normal, float *depth);
 
-bool IntersectCircle(Vector2 *centerA, int radiusA, Vector2 *centerB, int radiusB, 
+bool IntersectPolygonScalar(Vector2 *verticesA, int lengthA, Vector2 *verticesB, int lengthB, 
                     Vector2 *normal, float *depth);
 
-bool IntersectPolygonCircle(Vector2 *vertices, int length, Vector2 *center, float radius, 
+bool IntersectConvexGJK(Vector2 *verticesA, int lengthA, float radiusA, Vector2 centerA, 
+                    Vector2 *verticesB, int lengthB, float radiusB, Vector2 centerB, 
                     Vector2 *normal, float *depth);
 
+bool IntersectCircle(Vector2 *centerA, int radiusA, Vector2 *centerB, int radiusB, 
+                    Vector2 *normal, float *depth);
+
+bool IntersectPolygonCircle(Vector2 *vertices, Vector2 *normals, int length, Vector2 polygonCenter, 
+                    Vector2 *center, float radius, Vector2 *normal, float *depth);
+
+float SeparationConvex(Vector2 *verticesA, Vector2 *normalsA, int lengthA, float radiusA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, float radiusB, 
+                    Vector2 offset, Vector2 *axis);
+
 int FindClosestPointPolygon(Vector2 center, Vector2 *vertices, int length);
+int FindContactPointsPolygon(Vector2 *verticesA, Vector2 *normalsA, int lengthA, 
+                    Vector2 *verticesB, Vector2 *normalsB, int lengthB, 
+                    Vector2 normal, ContactPoint *points);
 
 float PolygonGetArea(Vector2 *vertices, int length);
 void PolygonGetCenter(Vector2 *result, Vector2 *vertices, int length);
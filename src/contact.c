@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <string.h>
+#include "contact.h"
+#include "alloc.h"
+
+void ContactList_Create(ContactList *list)
+{
+    list->contacts = NULL;
+    list->length = 0;
+    list->capacity = 0;
+}
+
+static bool ContactList_Grow(ContactList *list, int length)
+{
+    if (length <= list->capacity)
+    {
+        return true;
+    }
+
+    int capacity = (list->capacity > 0) ? list->capacity : 64;
+
+    while (capacity < length)
+    {
+        capacity *= 2;
+    }
+
+    Contact *temp = (Contact *)Alloc_Realloc(list->contacts, capacity * sizeof(Contact));
+
+    if (temp == NULL)
+    {
+        printf("Error when growing the contact list.\n");
+        return false;
+    }
+
+    list->contacts = temp;
+    list->capacity = capacity;
+
+    return true;
+}
+
+void ContactList_Push(ContactList *list, Contact *contact)
+{
+    if (!ContactList_Grow(list, list->length + 1))
+    {
+        return;
+    }
+
+    list->contacts[list->length++] = *contact;
+}
+
+void ContactList_Append(ContactList *list, ContactList *other)
+{
+    if (other->length == 0 || !ContactList_Grow(list, list->length + other->length))
+    {
+        return;
+    }
+
+    memcpy(&list->contacts[list->length], other->contacts, other->length * sizeof(Contact));
+    list->length += other->length;
+}
+
+/* grows to length, the new contacts are left for the caller to fill */
+bool ContactList_Resize(ContactList *list, int length)
+{
+    if (!ContactList_Grow(list, length))
+    {
+        return false;
+    }
+
+    list->length = length;
+
+    return true;
+}
+
+void ContactList_Clear(ContactList *list)
+{
+    list->length = 0;
+}
+
+void ContactList_Destroy(ContactList *list)
+{
+    if (list->contacts != NULL)
+    {
+        Alloc_Free(list->contacts);
+    }
+
+    ContactList_Create(list);
+}
+
+void ContactCache_Create(ContactCache *cache)
+{
+    cache->entries = NULL;
+    cache->previous = NULL;
+    cache->capacity = 0;
+    cache->previousCapacity = 0;
+    cache->length = 0;
+}
+
+static Uint32 ContactCache_Hash(Uint64 pair, Uint64 generations, Uint32 feature)
+{
+    Uint64 hash = (pair ^ (generations << 3) ^ ((Uint64)feature << 7)) * 0x9e3779b97f4a7c15ull;
+    return (Uint32)(hash >> 32);
+}
+
+/* the last solve becomes the lookup table, count is the points about to be stored */
+bool ContactCache_Begin(ContactCache *cache, int count)
+{
+    ContactCacheEntry *entries = cache->previous;
+    int capacity = cache->previousCapacity;
+
+    cache->previous = cache->entries;
+    cache->previousCapacity = cache->capacity;
+
+    int needed = (capacity > 0) ? capacity : 64;
+
+    while (needed < count * 2)
+    {
+        needed *= 2;
+    }
+
+    if (needed != capacity)
+    {
+        ContactCacheEntry *temp = (ContactCacheEntry *)Alloc_Realloc(entries, needed * sizeof(ContactCacheEntry));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the contact cache.\n");
+            cache->entries = entries;
+            cache->capacity = capacity;
+            cache->length = 0;
+            return false;
+        }
+
+        entries = temp;
+        capacity = needed;
+    }
+
+    for (int i = 0; i < capacity; ++i)
+    {
+        entries[i].pair = CONTACT_CACHE_EMPTY;
+    }
+
+    cache->entries = entries;
+    cache->capacity = capacity;
+    cache->length = 0;
+
+    return true;
+}
+
+void ContactCache_Store(ContactCache *cache, Uint64 pair, Uint64 generations, Uint32 feature, float normalImpulse)
+{
+    if (cache->length * 2 >= cache->capacity)
+    {
+        return;
+    }
+
+    Uint32 mask = (Uint32)cache->capacity - 1;
+    Uint32 slot = ContactCache_Hash(pair, generations, feature) & mask;
+
+    while (cache->entries[slot].pair != CONTACT_CACHE_EMPTY)
+    {
+        if (cache->entries[slot].pair == pair && cache->entries[slot].generations == generations && 
+            cache->entries[slot].feature == feature)
+        {
+            cache->entries[slot].normalImpulse = normalImpulse;
+            return;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    cache->entries[slot].pair = pair;
+    cache->entries[slot].generations = generations;
+    cache->entries[slot].feature = feature;
+    cache->entries[slot].normalImpulse = normalImpulse;
+    cache->length++;
+}
+
+/* impulse stored by the last solve for this point, 0 for a new one */
+float ContactCache_Find(ContactCache *cache, Uint64 pair, Uint64 generations, Uint32 feature)
+{
+    if (cache->previousCapacity == 0)
+    {
+        return 0.0f;
+    }
+
+    Uint32 mask = (Uint32)cache->previousCapacity - 1;
+    Uint32 slot = ContactCache_Hash(pair, generations, feature) & mask;
+
+    while (cache->previous[slot].pair != CONTACT_CACHE_EMPTY)
+    {
+        if (cache->previous[slot].pair == pair && cache->previous[slot].generations == generations && 
+            cache->previous[slot].feature == feature)
+        {
+            return cache->previous[slot].normalImpulse;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return 0.0f;
+}
+
+void ContactCache_Destroy(ContactCache *cache)
+{
+    Alloc_Free(cache->entries);
+    Alloc_Free(cache->previous);
+
+    ContactCache_Create(cache);
+}
@@ -0,0 +1,94 @@
+#ifndef _CONTACT_H_
+#define _CONTACT_H_
+
+#include "types.h"
+
+typedef struct ContactPoint             ContactPoint;
+typedef struct Contact                  Contact;
+typedef struct ContactList              ContactList;
+
+typedef struct ContactCacheEntry        ContactCacheEntry;
+typedef struct ContactCache             ContactCache;
+
+#define CONTACT_MAX_POINTS      2
+#define CONTACT_CACHE_EMPTY     0xffffffffffffffffull
+
+void ContactList_Create(ContactList *list);
+void ContactList_Push(ContactList *list, Contact *contact);
+void ContactList_Append(ContactList *list, ContactList *other);
+bool ContactList_Resize(ContactList *list, int length);
+void ContactList_Clear(ContactList *list);
+void ContactList_Destroy(ContactList *list);
+
+void ContactCache_Create(ContactCache *cache);
+bool ContactCache_Begin(ContactCache *cache, int count);
+void ContactCache_Store(ContactCache *cache, Uint64 pair, Uint64 generations, Uint32 feature, float normalImpulse);
+float ContactCache_Find(ContactCache *cache, Uint64 pair, Uint64 generations, Uint32 feature);
+void ContactCache_Destroy(ContactCache *cache);
+
+/*
+    feature names the pair of edges/vertices that produced the point, so the same
+    point can be found again next substep. normalImpulse is accumulated by the
+    solver, massNormal and velocityBias are computed once per substep.
+*/
+struct ContactPoint
+{
+    Vector2 position;
+    float depth;
+    Uint32 feature;
+
+    float normalImpulse;
+    float massNormal;
+    float velocityBias;
+};
+
+/*
+    Manifold of a narrow-phase test that hit, normal points from b to a and depth
+    is the deepest of the points. pair is the handle slots of a and b, generations
+    their handle generations, together the key of the contact cache: a body added
+    into a slot freed the same step does not warm start from the one it replaced.
+*/
+struct Contact
+{
+    int a;
+    int b;
+    Uint64 pair;
+    Uint64 generations;
+
+    Vector2 normal;
+    float depth;
+
+    ContactPoint points[CONTACT_MAX_POINTS];
+    int pointCount;
+};
+
+struct ContactList
+{
+    Contact *contacts;
+    int length;
+    int capacity;
+};
+
+struct ContactCacheEntry
+{
+    Uint64 pair;
+    Uint64 generations;
+    Uint32 feature;
+    float normalImpulse;
+};
+
+/*
+    Accumulated impulses of the last solve, looked up to warm start the next one.
+    Two open-addressing tables: previous is read while entries is filled, then they
+    swap in ContactCache_Begin. Tables only grow, at least twice the point count.
+*/
+struct ContactCache
+{
+    ContactCacheEntry *entries;
+    ContactCacheEntry *previous;
+    int capacity;
+    int previousCapacity;
+    int length;
+};
+
+#endif
@@ -7,65 +7,689 @@
 #include "body.h"
 #include "collision.h"
 #include "world.h"
+#include "alloc.h"
+#include "worldfile.h"
+#include "replay.h"
+
+#define ENGINE_RESERVED_BODIES 1024
 
 float elapsedTime = 0.0f;
 float lastTime = 0.0f;
 
-World *world;
-ColorList colorList;
-
 void ColorList_Create(ColorList *list)
 {
     list->colors = NULL;
     list->length = 0;
+    list->capacity = 0;
 }
 
-void ColorList_Push(ColorList *list, Color color)
+bool ColorList_Reserve(ColorList *list, int capacity)
 {
-    int len = list->length + 1;
-    list->colors = (Color *)realloc(list->colors, len * sizeof(Color));
+    if (capacity <= list->capacity)
+    {
+        return true;
+    }
+
+    Color *temp = (Color *)Alloc_Realloc(list->colors, capacity * sizeof(Color));
 
-    if (list->colors == NULL)
+    if (temp == NULL)
     {
         printf("Error when creating the color list.\n");
-        return;
+        return false;
     }
 
-    list->colors[len - 1] = color;
-    list->length = len;
+    list->colors = temp;
+    list->capacity = capacity;
+
+    return true;
 }
 
-void ColorList_Remove(ColorList *list, int index)
+/* colors are kept by body handle slot, they do not move when the bodies are compacted */
+void ColorList_Set(ColorList *list, int slot, Color color)
 {
-    for (int i = index; i < list->length - 1; ++i)
+    if (slot >= list->capacity)
     {
-        list->colors[i] = list->colors[i + 1];
-    }   
+        int capacity = (list->capacity > 0) ? list->capacity : 64;
+
+        while (capacity <= slot)
+        {
+            capacity *= 2;
+        }
+
+        if (!ColorList_Reserve(list, capacity))
+        {
+            return;
+        }
+    }
 
-    int len = list->length - 1;
-    Color *temp = (Color *)realloc(list->colors, len * sizeof(Body));
+    list->colors[slot] = color;
+
+    if (slot >= list->length)
+    {
+        list->length = slot + 1;
+    }
+}
+
+void ColorList_Destroy(ColorList *list)
+{
+    if (list->colors != NULL)
+    {
+        Alloc_Free(list->colors);
+    }
+
+    ColorList_Create(list);
+}
+
+void Snapshot_Create(Snapshot *snapshot)
+{
+    SDL_memset(snapshot, 0, sizeof(Snapshot));
+}
+
+bool Snapshot_Reserve(Snapshot *snapshot, int capacity)
+{
+    if (capacity <= snapshot->capacity)
+    {
+        return true;
+    }
+
+    int size = (snapshot->capacity > 0) ? snapshot->capacity : 64;
+
+    while (size < capacity) size *= 2;
+
+    SnapshotBody *temp = (SnapshotBody *)Alloc_Realloc(snapshot->bodies, size * sizeof(SnapshotBody));
 
     if (temp == NULL)
     {
-        printf("Error when reallocating the bodies.\n");
+        printf("Error when growing the snapshot.\n");
+        return false;
+    }
+
+    snapshot->bodies = temp;
+    snapshot->capacity = size;
+
+    return true;
+}
+
+void Snapshot_Destroy(Snapshot *snapshot)
+{
+    Alloc_Free(snapshot->bodies);
+    Snapshot_Create(snapshot);
+}
+
+void SnapshotBuffer_Create(SnapshotBuffer *buffer)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        Snapshot_Create(&buffer->snapshots[i]);
+    }
+
+    buffer->write = 0;
+    buffer->read = 1;
+    SDL_AtomicSet(&buffer->ready, 2);
+}
+
+/* the snapshot the simulation fills next, only it touches this one */
+Snapshot *SnapshotBuffer_BeginWrite(SnapshotBuffer *buffer)
+{
+    return &buffer->snapshots[buffer->write];
+}
+
+void SnapshotBuffer_Publish(SnapshotBuffer *buffer)
+{
+    /* the snapshot's writes must land before its index does */
+    SDL_MemoryBarrierRelease();
+    buffer->write = SDL_AtomicSet(&buffer->ready, buffer->write | SNAPSHOT_FRESH) & ~SNAPSHOT_FRESH;
+}
+
+/* the newest published snapshot, or the one already held when nothing new came in */
+Snapshot *SnapshotBuffer_Acquire(SnapshotBuffer *buffer)
+{
+    if (SDL_AtomicGet(&buffer->ready) & SNAPSHOT_FRESH)
+    {
+        buffer->read = SDL_AtomicSet(&buffer->ready, buffer->read) & ~SNAPSHOT_FRESH;
+        SDL_MemoryBarrierAcquire();
+    }
+
+    return &buffer->snapshots[buffer->read];
+}
+
+void SnapshotBuffer_Destroy(SnapshotBuffer *buffer)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        Snapshot_Destroy(&buffer->snapshots[i]);
+    }
+}
+
+void RenderBatch_Create(RenderBatch *batch)
+{
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->vertexLength = 0;
+    batch->indexLength = 0;
+    batch->vertexCapacity = 0;
+    batch->indexCapacity = 0;
+
+    batch->drawCalls = 0;
+    batch->vertexCount = 0;
+}
+
+void RenderBatch_Begin(RenderBatch *batch)
+{
+    batch->vertexLength = 0;
+    batch->indexLength = 0;
+    batch->drawCalls = 0;
+    batch->vertexCount = 0;
+}
+
+/* room for vertexCount more vertices and indexCount more indices, flushing when the batch is full */
+static bool RenderBatch_Reserve(RenderBatch *batch, SDL_Renderer *renderer, int vertexCount, int indexCount)
+{
+    if (batch->vertexLength + vertexCount > RENDER_BATCH_MAX_VERTICES)
+    {
+        RenderBatch_Flush(batch, renderer);
+    }
+
+    if (batch->vertexLength + vertexCount > batch->vertexCapacity)
+    {
+        int capacity = (batch->vertexCapacity > 0) ? batch->vertexCapacity : 1024;
+
+        while (capacity < batch->vertexLength + vertexCount) capacity *= 2;
+
+        SDL_Vertex *temp = (SDL_Vertex *)Alloc_Realloc(batch->vertices, capacity * sizeof(SDL_Vertex));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the render vertices.\n");
+            return false;
+        }
+
+        batch->vertices = temp;
+        batch->vertexCapacity = capacity;
+    }
+
+    if (batch->indexLength + indexCount > batch->indexCapacity)
+    {
+        int capacity = (batch->indexCapacity > 0) ? batch->indexCapacity : 2048;
+
+        while (capacity < batch->indexLength + indexCount) capacity *= 2;
+
+        int *temp = (int *)Alloc_Realloc(batch->indices, capacity * sizeof(int));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the render indices.\n");
+            return false;
+        }
+
+        batch->indices = temp;
+        batch->indexCapacity = capacity;
+    }
+
+    return true;
+}
+
+static void RenderBatch_PushVertex(RenderBatch *batch, float x, float y, Color color)
+{
+    SDL_Vertex *vertex = &batch->vertices[batch->vertexLength++];
+
+    vertex->position.x = x;
+    vertex->position.y = y;
+    vertex->color.r = color.r;
+    vertex->color.g = color.g;
+    vertex->color.b = color.b;
+    vertex->color.a = color.a;
+    vertex->tex_coord.x = 0.0f;
+    vertex->tex_coord.y = 0.0f;
+}
+
+/* convex polygon as a fan around its first vertex, moved by offset */
+void RenderBatch_PushPolygon(RenderBatch *batch, SDL_Renderer *renderer, Vector2 *vertices, int length, 
+                            Vector2 offset, Color color)
+{
+    if (length < 3 || !RenderBatch_Reserve(batch, renderer, length, (length - 2) * 3))
+    {
         return;
     }
 
-    list->colors = temp;
-    list->length = len; 
+    int first = batch->vertexLength;
+
+    for (int i = 0; i < length; ++i)
+    {
+        RenderBatch_PushVertex(batch, vertices[i][0] + offset[0], vertices[i][1] + offset[1], color);
+    }
+
+    for (int i = 1; i < length - 1; ++i)
+    {
+        batch->indices[batch->indexLength++] = first;
+        batch->indices[batch->indexLength++] = first + i;
+        batch->indices[batch->indexLength++] = first + i + 1;
+    }
 }
 
-void ColorList_Destroy(ColorList *list)
+/* a fan around the center, about one segment per 2 pixels of radius */
+void RenderBatch_PushCircle(RenderBatch *batch, SDL_Renderer *renderer, Vector2 center, float radius, Color color)
 {
-    if (list->colors != NULL)
+    int segments = SDL_max(RENDER_CIRCLE_MIN_SEGMENTS, SDL_min(RENDER_CIRCLE_MAX_SEGMENTS, (int)(radius * 0.5f)));
+
+    if (!RenderBatch_Reserve(batch, renderer, segments + 1, segments * 3))
+    {
+        return;
+    }
+
+    int first = batch->vertexLength;
+    float step = 2.0f * (float)PI / segments;
+
+    RenderBatch_PushVertex(batch, center[0], center[1], color);
+
+    for (int i = 0; i < segments; ++i)
+    {
+        RenderBatch_PushVertex(batch, center[0] + SDL_cosf(step * i) * radius, 
+                                center[1] + SDL_sinf(step * i) * radius, color);
+
+        batch->indices[batch->indexLength++] = first;
+        batch->indices[batch->indexLength++] = first + 1 + i;
+        batch->indices[batch->indexLength++] = first + 1 + (i + 1) % segments;
+    }
+}
+
+void RenderBatch_Flush(RenderBatch *batch, SDL_Renderer *renderer)
+{
+    if (batch->indexLength == 0)
+    {
+        return;
+    }
+
+    SDL_RenderGeometry(renderer, NULL, batch->vertices, batch->vertexLength, batch->indices, batch->indexLength);
+
+    batch->drawCalls++;
+    batch->vertexCount += batch->vertexLength;
+    batch->vertexLength = 0;
+    batch->indexLength = 0;
+}
+
+void RenderBatch_Destroy(RenderBatch *batch)
+{
+    Alloc_Free(batch->vertices);
+    Alloc_Free(batch->indices);
+
+    RenderBatch_Create(batch);
+}
+
+void Stats_Create(Stats *stats)
+{
+    SDL_memset(stats, 0, sizeof(Stats));
+}
+
+void Stats_Push(Stats *stats, WorldStats *world, float renderMillis)
+{
+    int cursor = stats->cursor;
+
+    stats->samples[Stats_Integrate][cursor] = world->integrateTime / 1e6f;
+    stats->samples[Stats_BroadPhase][cursor] = world->broadPhaseTime / 1e6f;
+    stats->samples[Stats_NarrowPhase][cursor] = world->narrowPhaseTime / 1e6f;
+    stats->samples[Stats_Resolve][cursor] = world->resolveTime / 1e6f;
+    stats->samples[Stats_Render][cursor] = renderMillis;
+
+    stats->cursor = (cursor + 1) % STATS_HISTORY_LENGTH;
+
+    if (stats->length < STATS_HISTORY_LENGTH)
+    {
+        stats->length++;
+    }
+}
+
+static int Stats_Compare(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+void Stats_Get(Stats *stats, StatsPhase phase, float *average, float *p99)
+{
+    *average = 0.0f;
+    *p99 = 0.0f;
+
+    if (stats->length == 0)
+    {
+        return;
+    }
+
+    float sorted[STATS_HISTORY_LENGTH];
+    float sum = 0.0f;
+
+    for (int i = 0; i < stats->length; ++i)
+    {
+        sorted[i] = stats->samples[phase][i];
+        sum += sorted[i];
+    }
+
+    qsort(sorted, stats->length, sizeof(float), Stats_Compare);
+
+    *average = sum / stats->length;
+    *p99 = sorted[(stats->length * 99) / 100];
+}
+
+/*
+    One bar per phase against the frame budget, the filled part is the rolling
+    average and the white tick the p99. No font ships with the engine, the
+    numbers go to the window title instead.
+*/
+void Stats_DrawOverlay(Stats *stats, Window *window)
+{
+    Color colors[Stats_PhaseCount] = {
+        {90, 170, 250, 255},
+        {250, 200, 60, 255},
+        {240, 110, 80, 255},
+        {160, 230, 120, 255},
+        {200, 130, 240, 255}
+    };
+
+    int x = 10;
+    int width = 200;
+    int height = 8;
+
+    for (int phase = 0; phase < Stats_PhaseCount; ++phase)
+    {
+        float average, p99;
+        Stats_Get(stats, phase, &average, &p99);
+
+        int y = 10 + phase * (height + 4);
+        int fill = (int)SDL_min(width, average / STATS_FRAME_BUDGET * width);
+        int tick = (int)SDL_min(width, p99 / STATS_FRAME_BUDGET * width);
+
+        SDL_Rect background = {x, y, width, height};
+        SDL_SetRenderDrawColor(window->renderer, 60, 60, 60, SDL_ALPHA_OPAQUE);
+        SDL_RenderFillRect(window->renderer, &background);
+
+        SDL_Rect bar = {x, y, fill, height};
+        SDL_SetRenderDrawColor(window->renderer, colors[phase].r, colors[phase].g, colors[phase].b, colors[phase].a);
+        SDL_RenderFillRect(window->renderer, &bar);
+
+        SDL_SetRenderDrawColor(window->renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+        SDL_RenderDrawLine(window->renderer, x + tick, y, x + tick, y + height - 1);
+    }
+
+    SDL_SetRenderDrawColor(window->renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+}
+
+static void Stats_UpdateTitle(Stats *stats, Window *window)
+{
+    const char *names[Stats_PhaseCount] = {"int", "bp", "np", "res", "draw"};
+
+    char title[256];
+    int length = snprintf(title, sizeof(title), "Bodies %i | Awake %i | Pairs %i | Steps %i x %i (%s) | Draws %i/%i verts | Allocs %llu |", 
+                        window->snapshot->length, window->snapshot->stats.awakeCount, window->snapshot->stats.pairCount, 
+                        window->snapshot->stats.fixedSteps, window->snapshot->stats.substepCount, 
+                        World_SubstepReasonName(window->snapshot->stats.substepReason), 
+                        window->batch.drawCalls, window->batch.vertexCount, 
+                        (unsigned long long)window->snapshot->frameAllocations);
+
+    for (int phase = 0; phase < Stats_PhaseCount && length < (int)sizeof(title); ++phase)
+    {
+        float average, p99;
+        Stats_Get(stats, phase, &average, &p99);
+
+        length += snprintf(title + length, sizeof(title) - length, " %s %.2f/%.2f", names[phase], average, p99);
+    }
+
+    SDL_SetWindowTitle(window->window, title);
+}
+
+static void Engine_Spawn(Window *window, Vector2 position)
+{
+    Uint8 rgb[3];
+    BodyHandle handle = Replay_Spawn(window->world, &window->random, position, rgb);
+
+    if (handle.slot != -1)
+    {
+        ColorList_Set(&window->colorList, handle.slot, Color_CreateRGB(rgb[0], rgb[1], rgb[2]));
+    }
+}
+
+static void Engine_Publish(Window *window, Uint64 allocations)
+{
+    World *world = window->world;
+    BodyList *bodies = &world->bodies;
+    Snapshot *snapshot = SnapshotBuffer_BeginWrite(&window->snapshots);
+
+    if (!Snapshot_Reserve(snapshot, bodies->length))
+    {
+        return;
+    }
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *body = &bodies->bodies[i];
+        SnapshotBody *copy = &snapshot->bodies[i];
+
+        copy->x = bodies->positionX[i];
+        copy->y = bodies->positionY[i];
+        copy->previousX = bodies->previousX[i];
+        copy->previousY = bodies->previousY[i];
+        copy->rotation = body->rotation;
+
+        copy->width = body->width;
+        copy->height = body->height;
+        copy->radius = body->radius;
+        copy->shape = body->shape;
+        copy->vertLength = 0;
+
+        if (body->shape == Polygon)
+        {
+            Vector2 *vertices = BodyList_GetVertices(bodies, i);
+            copy->vertLength = body->vertLength;
+
+            for (int v = 0; v < body->vertLength; ++v)
+            {
+                Vector2_Set(&copy->vertices[v], vertices[v][0] - copy->x, vertices[v][1] - copy->y);
+            }
+        }
+
+        copy->color = window->colorList.colors[bodies->slots[i]];
+    }
+
+    snapshot->length = bodies->length;
+    snapshot->alpha = world->alpha;
+    snapshot->fixedTimeStep = world->fixedTimeStep;
+    snapshot->publishTime = SDL_GetPerformanceCounter();
+    snapshot->stats = world->stats;
+    snapshot->frameAllocations = Alloc_GetCount() - allocations;
+
+    SnapshotBuffer_Publish(&window->snapshots);
+}
+
+static void Engine_Configure(World *world)
+{
+    World_SetThreadCount(world, SDL_GetCPUCount());
+    Replay_ConfigureWorld(world);
+}
+
+static void Engine_Save(Window *window)
+{
+    World *world = window->world;
+    const Uint8 *colors = NULL;
+
+    /* every slot got its color when its body was added */
+    if (window->colorList.length >= world->bodies.slotLength)
+    {
+        colors = (const Uint8 *)window->colorList.colors;
+    }
+
+    if (WorldFile_Save(world, ENGINE_SAVE_PATH, colors))
+    {
+        printf("Saved %i bodies to %s\n", world->bodies.length, ENGINE_SAVE_PATH);
+    }
+}
+
+/* swaps in the saved world, with the settings and broad-phase of the current one */
+static void Engine_Load(Window *window)
+{
+    World *world = window->world;
+    World *loaded;
+    Uint8 *colors;
+    int colorLength;
+
+    if (!WorldFile_Load(&loaded, ENGINE_SAVE_PATH, &colors, &colorLength))
+    {
+        return;
+    }
+
+    int slotLength = loaded->bodies.slotLength;
+
+    /* every slot of the loaded world needs a color before it is published */
+    if (!ColorList_Reserve(&window->colorList, slotLength))
+    {
+        Alloc_Free(colors);
+        World_Destroy(&loaded);
+        return;
+    }
+
+    /* a replay could not rebuild the loaded world */
+    if (window->replay.file != NULL)
     {
-        free(list->colors);
+        Replay_Close(&window->replay);
+        printf("Recording stopped by the load.\n");
+    }
+
+    Engine_Configure(loaded);
+    World_SetBroadPhase(loaded, world->broadPhase.type);
+    World_SetNarrowPhase(loaded, world->narrowPhase);
+    World_SetBounds(loaded, world->bounded, world->bounds[0], world->bounds[1]);
+
+    /* the file checked colorLength against slotLength, a colorless one gets the default */
+    if (colors != NULL)
+    {
+        SDL_memcpy(window->colorList.colors, colors, colorLength * sizeof(Color));
+    }
+    else
+    {
+        Color gray = Color_CreateRGB(200, 200, 200);
+
+        for (int i = 0; i < slotLength; ++i)
+        {
+            window->colorList.colors[i] = gray;
+        }
+    }
+
+    window->colorList.length = slotLength;
+
+    Alloc_Free(colors);
+    World_Destroy(&window->world);
+    window->world = loaded;
+
+    printf("Loaded %i bodies from %s\n", loaded->bodies.length, ENGINE_SAVE_PATH);
+}
+
+/*
+    Simulation thread: applies the commands of the main thread, advances the world
+    by the time since its last frame and publishes a snapshot whenever something
+    changed. It idles a millisecond at a time until the next fixed step is due.
+*/
+static int Engine_Simulate(void *data)
+{
+    Window *window = (Window *)data;
+    World *world = window->world;
+
+    Uint64 lastTime = SDL_GetPerformanceCounter();
+
+    while (SDL_AtomicGet(&window->simulating))
+    {
+        Uint64 allocations = Alloc_GetCount();
+        EngineCommands commands;
+
+        SDL_LockMutex(window->commandLock);
+        commands = window->commands;
+        window->commands.spawnCount = 0;
+        window->commands.nextBroadPhase = false;
+        window->commands.nextNarrowPhase = false;
+        window->commands.save = false;
+        window->commands.load = false;
+        SDL_UnlockMutex(window->commandLock);
+
+        if (commands.save)
+        {
+            Engine_Save(window);
+        }
+
+        if (commands.load)
+        {
+            Engine_Load(window);
+            world = window->world;
+        }
+
+        if (window->replay.file != NULL)
+        {
+            if (commands.nextBroadPhase)
+            {
+                Replay_RecordBroadPhase(&window->replay);
+            }
+
+            if (commands.nextNarrowPhase)
+            {
+                Replay_RecordNarrowPhase(&window->replay);
+            }
+
+            for (int i = 0; i < commands.spawnCount; ++i)
+            {
+                Replay_RecordSpawn(&window->replay, commands.spawns[i]);
+            }
+        }
+
+        if (commands.nextBroadPhase)
+        {
+            BroadPhaseType type = (world->broadPhase.type + 1) % BroadPhase_Count;
+            World_SetBroadPhase(world, type);
+            printf("Broad-phase: %s\n", BroadPhase_Name(type));
+        }
+
+        if (commands.nextNarrowPhase)
+        {
+            WorldNarrowPhase narrowPhase = (world->narrowPhase + 1) % WorldNarrowPhase_Count;
+            World_SetNarrowPhase(world, narrowPhase);
+            printf("Narrow-phase: %s\n", World_NarrowPhaseName(narrowPhase));
+        }
+
+        for (int i = 0; i < commands.spawnCount; ++i)
+        {
+            Engine_Spawn(window, commands.spawns[i]);
+        }
+
+        Uint64 currentTime = SDL_GetPerformanceCounter();
+        float elapsedTime = (float)(currentTime - lastTime) / window->frequency;
+        lastTime = currentTime;
+
+        /* bodies that fell past the ground are culled by the world bounds */
+        int steps = World_Advance(world, WORLD_MAX_SUBSTEPS, elapsedTime);
+
+        if (window->replay.file != NULL)
+        {
+            Replay_RecordFrame(&window->replay, elapsedTime, steps, world->checksum);
+        }
+
+        if (steps > 0 || commands.spawnCount > 0 || commands.nextBroadPhase || 
+            commands.nextNarrowPhase || commands.load)
+        {
+            Engine_Publish(window, allocations);
+        }
+        else
+        {
+            SDL_Delay(1);
+        }
     }
+
+    return 0;
 }
 
-void Engine_Init(const char *title, int width, int height, Window *window)
+void Engine_Init(const char *title, int width, int height, const char *recordPath, Window *window)
 {
-    srand(time(NULL));
+    /* Engine_CleanUp also runs after a failed init, what it releases starts out zeroed */
+    SDL_memset(window, 0, sizeof(Window));
+
+    /* xorshift needs a non zero state */
+    window->random = (Uint32)time(NULL) | 1;
 
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
     {
@@ -100,6 +724,7 @@ void Engine_Init(const char *title, int width, int height, Window *window)
     }
 
     window->running = true;
+    window->vsync = true;
     SDL_memset(window->input.isKeyPress, 0, SDL_NUM_SCANCODES);
     SDL_memset(window->input.isKeyRealese, 0, SDL_NUM_SCANCODES);
 
@@ -107,76 +732,91 @@ void Engine_Init(const char *title, int width, int height, Window *window)
     SDL_memset(window->input.mouseRealese, 0, 3);
 
     Vector2 gravity = {0.0f, 490.0f};
-    World_Create(&world, gravity);
-    ColorList_Create(&colorList);
+    World_Create(&window->world, gravity);
+    Engine_Configure(window->world);
 
-    Body ground;
-    Vector2 groundPos = {512, 551};
+    ColorList_Create(&window->colorList);
+    ColorList_Reserve(&window->colorList, ENGINE_RESERVED_BODIES);
+    RenderBatch_Create(&window->batch);
 
-    Body_NewBox(&ground, groundPos, 120.0f, 5.0f, 50.0f, 0.0f, 0.5f, true);
-    World_AddBody(world, &ground);
-    ColorList_Push(&colorList, Color_CreateRGB(160, 82, 45));
+    BodyHandle ground = Replay_CreateScene(window->world, width, height);
+    ColorList_Set(&window->colorList, ground.slot, Color_CreateRGB(160, 82, 45));
+
+    if (recordPath != NULL)
+    {
+        World_SetChecksums(window->world, true);
+
+        if (Replay_BeginRecord(&window->replay, recordPath, window->random, width, height))
+        {
+            printf("Recording to %s\n", recordPath);
+        }
+    }
  
+    Stats_Create(&window->stats);
+    window->showStats = true;
+
+    window->totalTicks = 0;
+    window->trialCount = 0;
+    window->avgMillis = 0;
+
     window->frequency = SDL_GetPerformanceFrequency();
     window->lastTime = SDL_GetPerformanceCounter();
-}
 
-void Engine_Update(Window *window)
-{   
-    Uint64 currentTime = SDL_GetPerformanceCounter();
-    Uint64 elapsedTicks = currentTime - window->lastTime;
-    float elapsedTime = (float)elapsedTicks / window->frequency;
+    SnapshotBuffer_Create(&window->snapshots);
+    window->snapshot = SnapshotBuffer_Acquire(&window->snapshots);
+
+    SDL_memset(&window->commands, 0, sizeof(EngineCommands));
+    window->commandLock = SDL_CreateMutex();
 
-    window->lastTime = currentTime;
-    World_Step(world, window, 20, elapsedTime);
+    SDL_AtomicSet(&window->simulating, 1);
+    window->simulation = SDL_CreateThread(Engine_Simulate, "simulation", window);
 
-    if (Input_MousePressed(&window->input, 0))
+    if (window->commandLock == NULL || window->simulation == NULL)
     {
-        float posX = window->input.mouse_x;
-        float posY = window->input.mouse_y;
+        printf("Error when starting the simulation thread.\n");
+        window->running = false;
+    }
+}
 
-        ShapeType shape = (rand() % 2 == 0) ? Box : Circle;
+void Engine_Update(Window *window)
+{
+    if (Input_KeyPressed(&window->input, SDL_SCANCODE_S))
+    {
+        window->showStats = !window->showStats;
+    }
 
-        if (shape == Box)
-        {
-            Body box;
-            Vector2 position = {posX, posY}; 
-            Color color = Color_CreateRGB(rand() % 255, rand() % 255, rand() % 255);
+    /* uncapped rendering, the simulation keeps its own rate either way */
+    if (Input_KeyPressed(&window->input, SDL_SCANCODE_V))
+    {
+        window->vsync = !window->vsync;
+        SDL_RenderSetVSync(window->renderer, window->vsync);
+    }
 
-            int width = (rand() % 5) + 4;
-            int height = (rand() % 5) + 4;
+    bool nextBroadPhase = Input_KeyPressed(&window->input, SDL_SCANCODE_B);
+    bool nextNarrowPhase = Input_KeyPressed(&window->input, SDL_SCANCODE_N);
+    bool spawn = Input_MousePressed(&window->input, 0);
+    bool save = Input_KeyPressed(&window->input, SDL_SCANCODE_F5);
+    bool load = Input_KeyPressed(&window->input, SDL_SCANCODE_F9);
 
-            Body_NewBox(&box, position, width, height, 50.0f, 0.0f, 0.5f, false);
-            World_AddBody(world, &box);
-            ColorList_Push(&colorList, color);
-            Body_Destroy(&box);
-        }
-        else
-        {
-            Body circle;
-            Vector2 position = {posX, posY}; 
-            Color color = Color_CreateRGB(rand() % 255, rand() % 255, rand() % 255);
+    if (!nextBroadPhase && !nextNarrowPhase && !spawn && !save && !load)
+    {
+        return;
+    }
 
-            int radius = (rand() % 5) + 2;
+    SDL_LockMutex(window->commandLock);
 
-            Body_NewCircle(&circle, position, radius, 50.0f, 0.0f, 0.5f, false);
-            World_AddBody(world, &circle);
-            ColorList_Push(&colorList, color);
-        }
-    }
+    EngineCommands *commands = &window->commands;
+    commands->nextBroadPhase = commands->nextBroadPhase || nextBroadPhase;
+    commands->nextNarrowPhase = commands->nextNarrowPhase || nextNarrowPhase;
+    commands->save = commands->save || save;
+    commands->load = commands->load || load;
 
-    for (int i = 0; i < world->bodies.length; ++i)
+    if (spawn && commands->spawnCount < ENGINE_MAX_SPAWNS)
     {
-        Body_GetAABB(&world->bodies.bodies[i]);
-
-        if (world->bodies.bodies[i].aabb[1][1] > world->bodies.bodies->aabb[1][1])
-        {
-            BodyList_Remove(&world->bodies, i);
-            ColorList_Remove(&colorList, i);
-        }
+        Vector2_Set(&commands->spawns[commands->spawnCount++], window->input.mouse_x, window->input.mouse_y);
     }
 
-    printf("Body Count: %i\n", world->bodies.length);
+    SDL_UnlockMutex(window->commandLock);
 }
 
 void Input_Begin(Input *input)
@@ -279,14 +919,83 @@ Color Color_CreateRGB(int r, int g, int b)
     return color;
 }
 
+/* queues the body in the frame batch, alpha of the way from its previous position */
+void Body_Debug(SnapshotBody *body, Window *window, float alpha)
+{
+    Vector2 position = {body->previousX + (body->x - body->previousX) * alpha, 
+                        body->previousY + (body->y - body->previousY) * alpha};
+
+    switch (body->shape)
+    {
+        case Box:
+        {
+            float c = SDL_cosf(body->rotation);
+            float s = SDL_sinf(body->rotation);
+            float w = body->width * 0.5f;
+            float h = body->height * 0.5f;
+
+            Vector2 corners[4] = {{-w * c + h * s, -w * s - h * c}, {w * c + h * s, w * s - h * c}, 
+                                {w * c - h * s, w * s + h * c}, {-w * c - h * s, -w * s + h * c}};
+
+            RenderBatch_PushPolygon(&window->batch, window->renderer, corners, 4, position, body->color);
+        }
+        break;
+
+        case Circle:
+            RenderBatch_PushCircle(&window->batch, window->renderer, position, body->radius, body->color);
+        break;
+
+        case Polygon:
+            RenderBatch_PushPolygon(&window->batch, window->renderer, body->vertices, body->vertLength, 
+                                    position, body->color);
+        break;
+    }
+}
+
 void Engine_Render(Window *window)
 {
+    Snapshot *snapshot = SnapshotBuffer_Acquire(&window->snapshots);
+    window->snapshot = snapshot;
+
+    Uint64 renderStart = SDL_GetPerformanceCounter();
+
+    /* carried forward from publishing, the simulation may be several frames ahead or behind */
+    float alpha = 1.0f;
+
+    if (snapshot->fixedTimeStep > 0.0f)
+    {
+        float since = (float)(renderStart - snapshot->publishTime) / window->frequency;
+        alpha = SDL_min(1.0f, snapshot->alpha + since / snapshot->fixedTimeStep);
+    }
+
     SDL_SetRenderDrawColor(window->renderer, 35, 35, 35, SDL_ALPHA_OPAQUE);
     SDL_RenderClear(window->renderer);
+
+    RenderBatch_Begin(&window->batch);
     
-    for (int i = 0; i < world->bodies.length; ++i)
+    for (int i = 0; i < snapshot->length; ++i)
     {
-        Body_Debug(&world->bodies.bodies[i], window, colorList.colors[i]);
+        Body_Debug(&snapshot->bodies[i], window, alpha);
+    }
+
+    RenderBatch_Flush(&window->batch, window->renderer);
+
+    Uint64 renderTicks = SDL_GetPerformanceCounter() - renderStart;
+
+    window->totalTicks += renderTicks;
+    window->trialCount++;
+    window->avgMillis = (Uint32)((window->totalTicks * 1000) / (window->frequency * window->trialCount));
+
+    Stats_Push(&window->stats, &snapshot->stats, (float)renderTicks * 1000.0f / window->frequency);
+
+    if (window->showStats)
+    {
+        Stats_DrawOverlay(&window->stats, window);
+    }
+
+    if (window->trialCount % 30 == 0)
+    {
+        Stats_UpdateTitle(&window->stats, window);
     }
 
     SDL_RenderPresent(window->renderer);
@@ -294,8 +1003,20 @@ void Engine_Render(Window *window)
 
 void Engine_CleanUp(Window *window)
 {
-    World_Destroy(&world);
-    ColorList_Destroy(&colorList);
+    SDL_AtomicSet(&window->simulating, 0);
+
+    if (window->simulation != NULL)
+    {
+        SDL_WaitThread(window->simulation, NULL);
+    }
+
+    SDL_DestroyMutex(window->commandLock);
+    SnapshotBuffer_Destroy(&window->snapshots);
+
+    Replay_Close(&window->replay);
+    World_Destroy(&window->world);
+    ColorList_Destroy(&window->colorList);
+    RenderBatch_Destroy(&window->batch);
     SDL_DestroyRenderer(window->renderer);
     SDL_DestroyWindow(window->window);
     SDL_Quit();
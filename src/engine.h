@@ -3,9 +3,16 @@
 
 #include <stdbool.h>
 #include <SDL2/SDL_events.h>
+#include <SDL2/SDL_atomic.h>
+#include "types.h"
+#include "world.h"
+#include "replay.h"
 
 typedef struct SDL_Window           SDL_Window;
 typedef struct SDL_Renderer         SDL_Renderer;
+typedef struct SDL_Vertex           SDL_Vertex;
+typedef struct SDL_Thread           SDL_Thread;
+typedef struct SDL_mutex            SDL_mutex;
 
 typedef struct Window               Window;
 typedef struct Color                Color;
@@ -13,8 +20,36 @@ typedef struct Input                Input;
 typedef struct Clock                Clock;
 
 typedef struct ColorList            ColorList;
+typedef struct RenderBatch          RenderBatch;
+typedef struct SnapshotBody         SnapshotBody;
+typedef struct Snapshot             Snapshot;
+typedef struct SnapshotBuffer       SnapshotBuffer;
+typedef struct EngineCommands       EngineCommands;
+typedef struct Stats                Stats;
+typedef enum   StatsPhase           StatsPhase;
 
-void Engine_Init(const char *title, int width, int height, Window *window);
+typedef struct Body                 Body;
+typedef struct World                World;
+typedef struct WorldStats           WorldStats;
+
+#define STATS_HISTORY_LENGTH        120
+#define STATS_FRAME_BUDGET          16.667f
+
+/* SDL_RenderGeometry takes an int count, flushing also keeps the buffers cache sized */
+#define RENDER_BATCH_MAX_VERTICES   65536
+#define RENDER_CIRCLE_MIN_SEGMENTS  8
+#define RENDER_CIRCLE_MAX_SEGMENTS  48
+
+/* clicks beyond this between two simulation frames are dropped */
+#define ENGINE_MAX_SPAWNS           64
+
+/* F5 saves the world there, F9 loads it back */
+#define ENGINE_SAVE_PATH            "scene.pine"
+
+/* the ready index carries this bit until the render thread takes it */
+#define SNAPSHOT_FRESH              4
+
+void Engine_Init(const char *title, int width, int height, const char *recordPath, Window *window);
 void Engine_Events(Window *window);
 void Engine_Update(Window *window);
 void Engine_Render(Window *window);
@@ -38,11 +73,46 @@ bool Input_MouseRealese(Input *input, int code);
 
 Color Color_CreateRGB(int r, int g, int b);
 
+void Body_Debug(SnapshotBody *body, Window *window, float alpha);
+
+void Stats_Create(Stats *stats);
+void Stats_Push(Stats *stats, WorldStats *world, float renderMillis);
+void Stats_Get(Stats *stats, StatsPhase phase, float *average, float *p99);
+void Stats_DrawOverlay(Stats *stats, Window *window);
+
+enum StatsPhase
+{
+    Stats_Integrate,
+    Stats_BroadPhase,
+    Stats_NarrowPhase,
+    Stats_Resolve,
+    Stats_Render,
+    Stats_PhaseCount
+};
+
 void ColorList_Create(ColorList *list);
-void ColorList_Push(ColorList *list, Color color);
-void ColorList_Remove(ColorList *list, int index);
+bool ColorList_Reserve(ColorList *list, int capacity);
+void ColorList_Set(ColorList *list, int slot, Color color);
 void ColorList_Destroy(ColorList *list);
 
+void Snapshot_Create(Snapshot *snapshot);
+bool Snapshot_Reserve(Snapshot *snapshot, int capacity);
+void Snapshot_Destroy(Snapshot *snapshot);
+
+void SnapshotBuffer_Create(SnapshotBuffer *buffer);
+Snapshot *SnapshotBuffer_BeginWrite(SnapshotBuffer *buffer);
+void SnapshotBuffer_Publish(SnapshotBuffer *buffer);
+Snapshot *SnapshotBuffer_Acquire(SnapshotBuffer *buffer);
+void SnapshotBuffer_Destroy(SnapshotBuffer *buffer);
+
+void RenderBatch_Create(RenderBatch *batch);
+void RenderBatch_Begin(RenderBatch *batch);
+void RenderBatch_PushPolygon(RenderBatch *batch, SDL_Renderer *renderer, Vector2 *vertices, int length, 
+                            Vector2 offset, Color color);
+void RenderBatch_PushCircle(RenderBatch *batch, SDL_Renderer *renderer, Vector2 center, float radius, Color color);
+void RenderBatch_Flush(RenderBatch *batch, SDL_Renderer *renderer);
+void RenderBatch_Destroy(RenderBatch *batch);
+
 struct Color
 {
     Uint8 r, g, b, a;
@@ -61,6 +131,106 @@ struct Input
     int mouse_x, mouse_y;
 };
 
+struct ColorList
+{
+    Color *colors;
+    int length;
+    int capacity;
+};
+
+/*
+    Triangles of the whole frame in one vertex and index buffer, submitted with
+    SDL_RenderGeometry when full and at the end of the frame. Colors are per vertex
+    so bodies of any color share a draw call. drawCalls and vertexCount count the
+    frame since RenderBatch_Begin.
+*/
+struct RenderBatch
+{
+    SDL_Vertex *vertices;
+    int *indices;
+    int vertexLength;
+    int indexLength;
+    int vertexCapacity;
+    int indexCapacity;
+
+    int drawCalls;
+    int vertexCount;
+};
+
+/*
+    What the render thread needs of a body: both ends of the last fixed step to
+    interpolate between, its shape and its color. Polygons also carry their
+    rotated vertices, relative to x, y.
+*/
+struct SnapshotBody
+{
+    float x, y;
+    float previousX, previousY;
+    float rotation;
+
+    float width, height, radius;
+    ShapeType shape;
+
+    Vector2 vertices[SHAPE_MAX_VERTICES];
+    int vertLength;
+
+    Color color;
+};
+
+/*
+    One published simulation frame. alpha is the world's leftover step fraction at
+    publishTime, the render thread carries it forward by its own clock.
+*/
+struct Snapshot
+{
+    SnapshotBody *bodies;
+    int length;
+    int capacity;
+
+    float alpha;
+    float fixedTimeStep;
+    Uint64 publishTime;
+
+    WorldStats stats;
+    Uint64 frameAllocations;
+};
+
+/*
+    Triple buffering without locks: the simulation owns snapshots[write], the render
+    thread snapshots[read], and ready holds the third index. Publishing swaps write
+    with ready and marks it SNAPSHOT_FRESH; acquiring swaps read with ready only when
+    it is fresh. Neither side ever waits, the renderer simply redraws the last frame
+    when nothing new came in.
+*/
+struct SnapshotBuffer
+{
+    Snapshot snapshots[3];
+    SDL_atomic_t ready;
+    int write;
+    int read;
+};
+
+/* input gathered by the main thread, applied by the simulation at its next frame */
+struct EngineCommands
+{
+    Vector2 spawns[ENGINE_MAX_SPAWNS];
+    int spawnCount;
+    bool nextBroadPhase;
+    bool nextNarrowPhase;
+    bool save;
+    bool load;
+};
+
+/*
+    Ring buffer of the last STATS_HISTORY_LENGTH frames, milliseconds per phase.
+*/
+struct Stats
+{
+    float samples[Stats_PhaseCount][STATS_HISTORY_LENGTH];
+    int length;
+    int cursor;
+};
+
 struct Window
 {
     SDL_Window *window;
@@ -68,6 +238,29 @@ struct Window
     Input input;
     bool running;
 
+    /*
+        The world, colorList, random state and replay belong to the simulation
+        thread once Engine_Init returns. The main thread only talks to it through
+        commands (under commandLock, once a frame) and reads what it publishes in
+        snapshots.
+    */
+    World *world;
+    ColorList colorList;
+    Uint32 random;
+    Replay replay;
+    SDL_Thread *simulation;
+    SDL_atomic_t simulating;
+    SDL_mutex *commandLock;
+    EngineCommands commands;
+    SnapshotBuffer snapshots;
+
+    RenderBatch batch;
+    Snapshot *snapshot;
+    bool vsync;
+
+    Stats stats;
+    bool showStats;
+
     Uint64 frequency;
     Uint64 lastTime;
     Uint64 totalTicks;
@@ -76,10 +269,4 @@ struct Window
     Uint32 avgMillis;
 };
 
-struct ColorList
-{
-    Color *colors;
-    int length;
-};
-
 #endif
\ No newline at end of file
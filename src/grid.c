@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "broadphase.h"
+#include "body.h"
+#include "alloc.h"
+
+static Uint32 Grid_Hash(int cellX, int cellY, int bucketCount)
+{
+    Uint32 h = ((Uint32)cellX * 73856093u) ^ ((Uint32)cellY * 19349663u);
+    return h & (Uint32)(bucketCount - 1);
+}
+
+static int Grid_Cell(SpatialGrid *grid, float value)
+{
+    return (int)floorf(value * grid->invCellSize);
+}
+
+static bool Grid_Reserve(SpatialGrid *grid, int length)
+{
+    if (length <= grid->entryCapacity && grid->bucketStart != NULL)
+    {
+        return true;
+    }
+
+    int capacity = (grid->entryCapacity > 0) ? grid->entryCapacity : 256;
+
+    while (capacity < length)
+    {
+        capacity *= 2;
+    }
+
+    GridEntry *entries = (GridEntry *)Alloc_Realloc(grid->entries, capacity * sizeof(GridEntry));
+    GridEntry *sorted = (GridEntry *)Alloc_Realloc(grid->sorted, capacity * sizeof(GridEntry));
+
+    if (entries == NULL || sorted == NULL)
+    {
+        printf("Error when growing the grid entries.\n");
+        return false;
+    }
+
+    grid->entries = entries;
+    grid->sorted = sorted;
+    grid->entryCapacity = capacity;
+
+    int bucketCount = 1;
+
+    while (bucketCount < capacity * 2)
+    {
+        bucketCount *= 2;
+    }
+
+    int *bucketStart = (int *)Alloc_Realloc(grid->bucketStart, (bucketCount + 1) * sizeof(int));
+
+    if (bucketStart == NULL)
+    {
+        printf("Error when growing the grid buckets.\n");
+        return false;
+    }
+
+    grid->bucketStart = bucketStart;
+    grid->bucketCount = bucketCount;
+
+    return true;
+}
+
+static void Grid_PushLarge(SpatialGrid *grid, int index)
+{
+    if (grid->largeLength == grid->largeCapacity)
+    {
+        int capacity = (grid->largeCapacity > 0) ? grid->largeCapacity * 2 : 8;
+        int *temp = (int *)Alloc_Realloc(grid->large, capacity * sizeof(int));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the large body list.\n");
+            return;
+        }
+
+        grid->large = temp;
+        grid->largeCapacity = capacity;
+    }
+
+    grid->large[grid->largeLength++] = index;
+}
+
+void SpatialGrid_Create(SpatialGrid *grid, float cellSize)
+{
+    grid->cellSize = cellSize;
+    grid->invCellSize = 1.0f / cellSize;
+
+    grid->entries = NULL;
+    grid->sorted = NULL;
+    grid->entryLength = 0;
+    grid->entryCapacity = 0;
+
+    grid->bucketStart = NULL;
+    grid->bucketCount = 0;
+
+    grid->large = NULL;
+    grid->largeLength = 0;
+    grid->largeCapacity = 0;
+}
+
+void SpatialGrid_Reserve(SpatialGrid *grid, int capacity)
+{
+    Grid_Reserve(grid, capacity * GRID_RESERVE_BODY_CELLS);
+}
+
+void SpatialGrid_Build(SpatialGrid *grid, BodyList *bodies)
+{
+    grid->entryLength = 0;
+    grid->largeLength = 0;
+
+    int total = 0;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *body = &bodies->bodies[i];
+
+        int spanX = Grid_Cell(grid, body->aabb[1][0]) - Grid_Cell(grid, body->aabb[0][0]) + 1;
+        int spanY = Grid_Cell(grid, body->aabb[1][1]) - Grid_Cell(grid, body->aabb[0][1]) + 1;
+
+        if (spanX * spanY <= GRID_MAX_BODY_CELLS)
+        {
+            total += spanX * spanY;
+        }
+    }
+
+    if (!Grid_Reserve(grid, total))
+    {
+        return;
+    }
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *body = &bodies->bodies[i];
+
+        int minX = Grid_Cell(grid, body->aabb[0][0]);
+        int minY = Grid_Cell(grid, body->aabb[0][1]);
+        int maxX = Grid_Cell(grid, body->aabb[1][0]);
+        int maxY = Grid_Cell(grid, body->aabb[1][1]);
+
+        if ((maxX - minX + 1) * (maxY - minY + 1) > GRID_MAX_BODY_CELLS)
+        {
+            Grid_PushLarge(grid, i);
+            continue;
+        }
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                GridEntry entry = {i, x, y, Grid_Hash(x, y, grid->bucketCount)};
+                grid->entries[grid->entryLength++] = entry;
+            }
+        }
+    }
+
+    /*
+        Counting sort by bucket, keeps the entries of one bucket contiguous
+        and in body order so the pair output is deterministic.
+    */
+    memset(grid->bucketStart, 0, (grid->bucketCount + 1) * sizeof(int));
+
+    for (int i = 0; i < grid->entryLength; ++i)
+    {
+        grid->bucketStart[grid->entries[i].hash + 1]++;
+    }
+
+    for (int i = 0; i < grid->bucketCount; ++i)
+    {
+        grid->bucketStart[i + 1] += grid->bucketStart[i];
+    }
+
+    for (int i = 0; i < grid->entryLength; ++i)
+    {
+        grid->sorted[grid->bucketStart[grid->entries[i].hash]++] = grid->entries[i];
+    }
+
+    for (int i = grid->bucketCount; i > 0; --i)
+    {
+        grid->bucketStart[i] = grid->bucketStart[i - 1];
+    }
+
+    grid->bucketStart[0] = 0;
+}
+
+void SpatialGrid_FindPairs(SpatialGrid *grid, BodyList *bodies, PairList *pairs)
+{
+    for (int bucket = 0; bucket < grid->bucketCount; ++bucket)
+    {
+        int start = grid->bucketStart[bucket];
+        int end = grid->bucketStart[bucket + 1];
+
+        for (int i = start; i < end; ++i)
+        {
+            GridEntry *e0 = &grid->sorted[i];
+
+            for (int j = i + 1; j < end; ++j)
+            {
+                GridEntry *e1 = &grid->sorted[j];
+
+                if (e0->cellX != e1->cellX || e0->cellY != e1->cellY)
+                {
+                    continue;
+                }
+
+                Body *b0 = &bodies->bodies[e0->body];
+                Body *b1 = &bodies->bodies[e1->body];
+
+                if ((b0->isStatic && b1->isStatic) || !AABB_Overlap(b0->aabb, b1->aabb))
+                {
+                    continue;
+                }
+
+                /*
+                    Two bodies can share several cells, only the cell holding the
+                    min corner of their overlap reports the pair.
+                */
+                int cellX = Grid_Cell(grid, fmaxf(b0->aabb[0][0], b1->aabb[0][0]));
+                int cellY = Grid_Cell(grid, fmaxf(b0->aabb[0][1], b1->aabb[0][1]));
+
+                if (cellX != e0->cellX || cellY != e0->cellY)
+                {
+                    continue;
+                }
+
+                PairList_Push(pairs, e0->body, e1->body);
+            }
+        }
+    }
+
+    for (int i = 0; i < grid->largeLength; ++i)
+    {
+        int index = grid->large[i];
+        Body *b0 = &bodies->bodies[index];
+
+        for (int j = 0; j < bodies->length; ++j)
+        {
+            Body *b1 = &bodies->bodies[j];
+
+            if (j == index || (b0->isStatic && b1->isStatic))
+            {
+                continue;
+            }
+
+            /* large vs large is reported from the lower index only */
+            int spanX = Grid_Cell(grid, b1->aabb[1][0]) - Grid_Cell(grid, b1->aabb[0][0]) + 1;
+            int spanY = Grid_Cell(grid, b1->aabb[1][1]) - Grid_Cell(grid, b1->aabb[0][1]) + 1;
+
+            if (spanX * spanY > GRID_MAX_BODY_CELLS && j < index)
+            {
+                continue;
+            }
+
+            if (AABB_Overlap(b0->aabb, b1->aabb))
+            {
+                PairList_Push(pairs, (index < j) ? index : j, (index < j) ? j : index);
+            }
+        }
+    }
+}
+
+void SpatialGrid_Destroy(SpatialGrid *grid)
+{
+    if (grid->entries != NULL)
+    {
+        Alloc_Free(grid->entries);
+    }
+
+    if (grid->sorted != NULL)
+    {
+        Alloc_Free(grid->sorted);
+    }
+
+    if (grid->bucketStart != NULL)
+    {
+        Alloc_Free(grid->bucketStart);
+    }
+
+    if (grid->large != NULL)
+    {
+        Alloc_Free(grid->large);
+    }
+
+    SpatialGrid_Create(grid, grid->cellSize);
+}
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "world.h"
+#include "body.h"
+#include "alloc.h"
+#include "replay.h"
+
+#define HEADLESS_DEFAULT_STEPS      600
+#define HEADLESS_DEFAULT_BODIES     500
+#define HEADLESS_ITERATIONS         20
+#define HEADLESS_TIME_STEP          (1.0f / 60.0f)
+
+/* steps and spawn cycles run before the allocation counts start, buffers grow to size in them */
+#define HEADLESS_WARM_STEPS         10
+#define HEADLESS_SPAWN_BATCH        32
+#define HEADLESS_SPAWN_CYCLES       20
+#define HEADLESS_SPAWN_SEED         0x2545f491u
+
+static double Headless_Seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+/*
+    Reruns a recording of the engine as fast as it can, feeding the recorded frame
+    times and spawns, and stops at the first frame whose checksum differs.
+*/
+static int Headless_Replay(const char *path, int threads)
+{
+    Replay replay;
+
+    if (!Replay_Open(&replay, path))
+    {
+        return 1;
+    }
+
+    World *world;
+    Vector2 gravity = {0.0f, 490.0f};
+    World_Create(&world, gravity);
+
+    if (world == NULL)
+    {
+        Replay_Close(&replay);
+        return 1;
+    }
+
+    World_SetThreadCount(world, threads);
+    World_SetChecksums(world, true);
+    Replay_ConfigureWorld(world);
+    Replay_CreateScene(world, replay.width, replay.height);
+
+    Uint32 random = replay.seed;
+    ReplayEvent event;
+
+    long frames = 0;
+    long steps = 0;
+    long spawns = 0;
+    long checks = 0;
+    int result = 0;
+
+    double start = Headless_Seconds();
+
+    while (Replay_Read(&replay, &event))
+    {
+        if (event.type == ReplayEvent_Spawn)
+        {
+            Vector2 position = {event.x, event.y};
+            Uint8 color[3];
+
+            Replay_Spawn(world, &random, position, color);
+            spawns++;
+        }
+        else if (event.type == ReplayEvent_BroadPhase)
+        {
+            World_SetBroadPhase(world, (world->broadPhase.type + 1) % BroadPhase_Count);
+        }
+        else if (event.type == ReplayEvent_NarrowPhase)
+        {
+            World_SetNarrowPhase(world, (world->narrowPhase + 1) % WorldNarrowPhase_Count);
+        }
+        else if (event.type == ReplayEvent_Frame)
+        {
+            steps += World_Advance(world, WORLD_MAX_SUBSTEPS, event.elapsedTime);
+            frames++;
+        }
+        else if (event.type == ReplayEvent_Checksum)
+        {
+            checks++;
+
+            if (event.checksum != world->checksum)
+            {
+                printf("Diverged at frame %li (step %li): checksum %016llx, recorded %016llx\n", frames, steps,
+                        (unsigned long long)world->checksum, (unsigned long long)event.checksum);
+                result = 1;
+                break;
+            }
+        }
+    }
+
+    double elapsed = Headless_Seconds() - start;
+
+    printf("Replay: %s | Seed: %08x | Threads: %i\n", path, replay.seed, world->threads.count);
+    printf("Frames: %li | Steps: %li | Spawns: %li | Bodies: %i | Time: %.3fs | Steps/s: %.1f\n", 
+            frames, steps, spawns, world->bodies.length, elapsed, (elapsed > 0.0) ? steps / elapsed : 0.0);
+    printf("Checksums: %li %s\n", checks, (result == 0) ? "matched" : "diverged");
+
+    Replay_Close(&replay);
+    World_Destroy(&world);
+
+    return result;
+}
+
+/*
+    Spawns a batch through Replay_Spawn above the pile, steps, removes it and steps
+    again. The random state restarts each cycle, every cycle spawns the same bodies.
+*/
+static void Headless_SpawnCycle(World *world)
+{
+    BodyHandle handles[HEADLESS_SPAWN_BATCH];
+    Uint32 random = HEADLESS_SPAWN_SEED;
+    Uint8 color[3];
+
+    for (int i = 0; i < HEADLESS_SPAWN_BATCH; ++i)
+    {
+        Vector2 position = {112.0f + i * 24.0f, -400.0f};
+        handles[i] = Replay_Spawn(world, &random, position, color);
+    }
+
+    World_Step(world, HEADLESS_ITERATIONS, HEADLESS_TIME_STEP);
+
+    for (int i = 0; i < HEADLESS_SPAWN_BATCH; ++i)
+    {
+        World_RemoveBody(world, handles[i]);
+    }
+
+    World_Step(world, HEADLESS_ITERATIONS, HEADLESS_TIME_STEP);
+}
+
+/*
+    Steps a world as fast as it can, no window and no vsync. Once warm, stepping and
+    spawning then removing bodies must not allocate: the counts after the warm-up are
+    printed and any allocation makes it exit 1.
+    usage: headless.out [steps] [bodies] [broad-phase 0..3] [threads]
+           headless.out --replay FILE [threads]     (reruns a recording of engine.out --record FILE)
+*/
+int main(int argc, char *args[])
+{
+    if (argc > 2 && strcmp(args[1], "--replay") == 0)
+    {
+        return Headless_Replay(args[2], (argc > 3) ? atoi(args[3]) : 1);
+    }
+
+    int steps = (argc > 1) ? atoi(args[1]) : HEADLESS_DEFAULT_STEPS;
+    int count = (argc > 2) ? atoi(args[2]) : HEADLESS_DEFAULT_BODIES;
+    BroadPhaseType type = (argc > 3) ? (BroadPhaseType)atoi(args[3]) : BroadPhase_Grid;
+    int threads = (argc > 4) ? atoi(args[4]) : 1;
+
+    if (type < 0 || type >= BroadPhase_Count)
+    {
+        printf("Error unknown broad-phase %i.\n", type);
+        return 1;
+    }
+
+    srand(0);
+
+    World *world;
+    Vector2 gravity = {0.0f, 490.0f};
+    World_Create(&world, gravity);
+
+    if (world == NULL)
+    {
+        return 1;
+    }
+
+    World_SetBroadPhase(world, type);
+    World_SetThreadCount(world, threads);
+    World_Reserve(world, count + 1 + HEADLESS_SPAWN_BATCH);
+
+    Body ground;
+    Vector2 groundPos = {512, 551};
+
+    Body_NewBox(&ground, &world->shapes, groundPos, 120.0f, 5.0f, 50.0f, 0.0f, 0.5f, true);
+    World_AddBody(world, &ground);
+
+    int columns = 25;
+
+    for (int i = 0; i < count; ++i)
+    {
+        Body body;
+        Vector2 position = {112.0f + (i % columns) * 32.0f, 500.0f - (i / columns) * 32.0f};
+
+        if (rand() % 2 == 0)
+        {
+            Body_NewBox(&body, &world->shapes, position, (rand() % 3) + 2, (rand() % 3) + 2, 
+                        50.0f, 0.0f, 0.5f, false);
+        }
+        else
+        {
+            Body_NewCircle(&body, &world->shapes, position, (rand() % 3) + 2, 50.0f, 0.0f, 0.5f, false);
+        }
+
+        World_AddBody(world, &body);
+    }
+
+    for (int i = 0; i < HEADLESS_WARM_STEPS; ++i)
+    {
+        World_Step(world, HEADLESS_ITERATIONS, HEADLESS_TIME_STEP);
+    }
+
+    Uint64 allocations = Alloc_GetCount();
+    long pairs = 0;
+
+    double start = Headless_Seconds();
+
+    for (int i = 0; i < steps; ++i)
+    {
+        World_Step(world, HEADLESS_ITERATIONS, HEADLESS_TIME_STEP);
+        pairs += world->pairCount;
+    }
+
+    double elapsed = Headless_Seconds() - start;
+    Uint64 stepAllocations = Alloc_GetCount() - allocations;
+
+    /* the first cycle grows the shape library and contact buffers to the batch */
+    Headless_SpawnCycle(world);
+    allocations = Alloc_GetCount();
+
+    for (int i = 0; i < HEADLESS_SPAWN_CYCLES; ++i)
+    {
+        Headless_SpawnCycle(world);
+    }
+
+    Uint64 spawnAllocations = Alloc_GetCount() - allocations;
+
+    printf("Broad-phase: %s | Threads: %i\n", BroadPhase_Name(type), world->threads.count);
+    printf("Bodies: %i | Steps: %i | Time: %.3fs | Steps/s: %.1f\n", 
+            world->bodies.length, steps, elapsed, (elapsed > 0.0) ? steps / elapsed : 0.0);
+    printf("Pairs per step: %.1f | Allocations after %i warm steps: %llu | Spawn/remove of %i x %i: %llu\n", 
+            (steps > 0) ? (double)pairs / steps : 0.0, HEADLESS_WARM_STEPS, (unsigned long long)stepAllocations,
+            HEADLESS_SPAWN_CYCLES, HEADLESS_SPAWN_BATCH, (unsigned long long)spawnAllocations);
+
+    World_Destroy(&world);
+
+    if (stepAllocations != 0 || spawnAllocations != 0)
+    {
+        printf("Error the warm world allocated.\n");
+        return 1;
+    }
+
+    return 0;
+}
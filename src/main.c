@@ -1,10 +1,22 @@
 #include <stdio.h>
+#include <string.h>
 #include "engine.h"
 
+/*
+    usage: engine.out [--record FILE]
+           --record logs the seed, frame times and spawns to FILE, headless.out --replay FILE reruns them
+*/
 int main(int argc, char *args[])
 {
+    const char *recordPath = NULL;
+
+    if (argc > 2 && strcmp(args[1], "--record") == 0)
+    {
+        recordPath = args[2];
+    }
+
     Window GameWindow;
-    Engine_Init("The most fucking engine of humanity!1!!", 1024, 576, &GameWindow);
+    Engine_Init("The most fucking engine of humanity!1!!", 1024, 576, recordPath, &GameWindow);
 
     while (GameWindow.running)
     {
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "replay.h"
+#include "world.h"
+#include "body.h"
+
+/* xorshift32, rand() differs between C libraries and recordings must not */
+Uint32 Replay_Random(Uint32 *state)
+{
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+/* the settings that change the results, the thread count does not */
+void Replay_ConfigureWorld(World *world)
+{
+    World_Reserve(world, REPLAY_RESERVED_BODIES);
+    World_SetParallelResolve(world, true);
+    World_SetSleeping(world, true);
+    World_SetContinuous(world, true);
+    World_SetAdaptiveSubsteps(world, true, WORLD_MIN_SUBSTEPS, WORLD_MAX_SUBSTEPS);
+}
+
+/* the ground, and bounds culling anything entirely below it or far off the sides */
+BodyHandle Replay_CreateScene(World *world, int width, int height)
+{
+    Body ground;
+    Vector2 groundPos = {512, 551};
+
+    Body_NewBox(&ground, &world->shapes, groundPos, 120.0f, 5.0f, 50.0f, 0.0f, 0.5f, true);
+    BodyHandle handle = World_AddBody(world, &ground);
+
+    Vector2 boundsMin = {-width, -height * 4.0f};
+    Vector2 boundsMax = {width * 2.0f, groundPos[1] + ground.height * 0.5f};
+    World_SetBounds(world, true, boundsMin, boundsMax);
+
+    return handle;
+}
+
+/* a random box, circle or polygon at position, its color drawn from the same random state */
+BodyHandle Replay_Spawn(World *world, Uint32 *random, Vector2 position, Uint8 color[3])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        color[i] = Replay_Random(random) % 255;
+    }
+
+    Body body;
+    bool created;
+
+    Uint32 kind = Replay_Random(random) % 3;
+
+    if (kind == 0)
+    {
+        int width = (Replay_Random(random) % 5) + 4;
+        int height = (Replay_Random(random) % 5) + 4;
+
+        created = Body_NewBox(&body, &world->shapes, position, width, height, 50.0f, 0.0f, 0.5f, false);
+    }
+    else if (kind == 1)
+    {
+        int radius = (Replay_Random(random) % 5) + 2;
+
+        created = Body_NewCircle(&body, &world->shapes, position, radius, 50.0f, 0.0f, 0.5f, false);
+    }
+    else
+    {
+        /* 3 to 8 points around a circle, a hull of the same size as the boxes */
+        Vector2 points[SHAPE_MAX_VERTICES];
+        int length = (Replay_Random(random) % (SHAPE_MAX_VERTICES - 2)) + 3;
+        float radius = (float)(Replay_Random(random) % 3) + 2.0f;
+
+        for (int i = 0; i < length; ++i)
+        {
+            float angle = (i + (Replay_Random(random) % 100) / 200.0f) * 2.0f * (float)PI / length;
+            Vector2_Set(&points[i], cosf(angle) * radius, sinf(angle) * radius);
+        }
+
+        created = Body_NewPolygon(&body, &world->shapes, position, points, length, 50.0f, 0.0f, 0.5f, false);
+    }
+
+    if (!created)
+    {
+        BodyHandle none = {-1, 0};
+        return none;
+    }
+
+    return World_AddBody(world, &body);
+}
+
+static void Replay_Write(Replay *replay, const void *data, size_t size)
+{
+    if (replay->file != NULL && fwrite(data, size, 1, replay->file) != 1)
+    {
+        printf("Error when writing the recording, it stops here.\n");
+        Replay_Close(replay);
+    }
+}
+
+static void Replay_WriteType(Replay *replay, ReplayEventType type)
+{
+    Uint8 value = (Uint8)type;
+    Replay_Write(replay, &value, sizeof(Uint8));
+}
+
+bool Replay_BeginRecord(Replay *replay, const char *path, Uint32 seed, int width, int height)
+{
+    replay->file = fopen(path, "wb");
+    replay->seed = seed;
+    replay->width = width;
+    replay->height = height;
+
+    if (replay->file == NULL)
+    {
+        printf("Error when opening %s for recording.\n", path);
+        return false;
+    }
+
+    Uint32 header[5] = {REPLAY_MAGIC, REPLAY_VERSION, seed, (Uint32)width, (Uint32)height};
+    Replay_Write(replay, header, sizeof(header));
+
+    return replay->file != NULL;
+}
+
+void Replay_RecordSpawn(Replay *replay, Vector2 position)
+{
+    Replay_WriteType(replay, ReplayEvent_Spawn);
+    Replay_Write(replay, position, sizeof(Vector2));
+}
+
+void Replay_RecordBroadPhase(Replay *replay)
+{
+    Replay_WriteType(replay, ReplayEvent_BroadPhase);
+}
+
+void Replay_RecordNarrowPhase(Replay *replay)
+{
+    Replay_WriteType(replay, ReplayEvent_NarrowPhase);
+}
+
+void Replay_RecordFrame(Replay *replay, float elapsedTime, int steps, Uint64 checksum)
+{
+    Replay_WriteType(replay, ReplayEvent_Frame);
+    Replay_Write(replay, &elapsedTime, sizeof(float));
+
+    /* frames that only banked time change nothing to check */
+    if (steps > 0)
+    {
+        Replay_WriteType(replay, ReplayEvent_Checksum);
+        Replay_Write(replay, &checksum, sizeof(Uint64));
+    }
+}
+
+bool Replay_Open(Replay *replay, const char *path)
+{
+    replay->file = fopen(path, "rb");
+
+    if (replay->file == NULL)
+    {
+        printf("Error when opening the recording %s.\n", path);
+        return false;
+    }
+
+    Uint32 header[5];
+
+    if (fread(header, sizeof(header), 1, replay->file) != 1 ||
+        header[0] != REPLAY_MAGIC || header[1] != REPLAY_VERSION)
+    {
+        printf("Error %s is not a recording of version %i.\n", path, REPLAY_VERSION);
+        Replay_Close(replay);
+        return false;
+    }
+
+    replay->seed = header[2];
+    replay->width = (int)header[3];
+    replay->height = (int)header[4];
+
+    return true;
+}
+
+/* next event of the recording, false at its end */
+bool Replay_Read(Replay *replay, ReplayEvent *event)
+{
+    Uint8 type;
+
+    if (replay->file == NULL || fread(&type, sizeof(Uint8), 1, replay->file) != 1)
+    {
+        return false;
+    }
+
+    memset(event, 0, sizeof(ReplayEvent));
+    event->type = (ReplayEventType)type;
+
+    switch (event->type)
+    {
+        case ReplayEvent_Spawn:
+        {
+            Vector2 position;
+
+            if (fread(position, sizeof(Vector2), 1, replay->file) != 1)
+            {
+                return false;
+            }
+
+            event->x = position[0];
+            event->y = position[1];
+        }
+        break;
+
+        case ReplayEvent_BroadPhase:
+        case ReplayEvent_NarrowPhase:
+        break;
+
+        case ReplayEvent_Frame:
+            return fread(&event->elapsedTime, sizeof(float), 1, replay->file) == 1;
+
+        case ReplayEvent_Checksum:
+            return fread(&event->checksum, sizeof(Uint64), 1, replay->file) == 1;
+
+        default:
+            printf("Error unknown event %i in the recording.\n", type);
+            return false;
+    }
+
+    return true;
+}
+
+void Replay_Close(Replay *replay)
+{
+    if (replay->file != NULL)
+    {
+        fclose(replay->file);
+        replay->file = NULL;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include "types.h"
+#include "body.h"
+#include <stdio.h>
+#include <stdbool.h>
+
+typedef struct World                    World;
+
+typedef struct Replay                   Replay;
+typedef struct ReplayEvent              ReplayEvent;
+typedef enum   ReplayEventType          ReplayEventType;
+
+#define REPLAY_MAGIC            0x43455250u     /* "PREC" read as little-endian */
+#define REPLAY_VERSION          2
+
+/* the grid's bucket count follows the reserved capacity, and the pair order with it */
+#define REPLAY_RESERVED_BODIES  1024
+
+Uint32 Replay_Random(Uint32 *state);
+void Replay_ConfigureWorld(World *world);
+BodyHandle Replay_CreateScene(World *world, int width, int height);
+BodyHandle Replay_Spawn(World *world, Uint32 *random, Vector2 position, Uint8 color[3]);
+
+bool Replay_BeginRecord(Replay *replay, const char *path, Uint32 seed, int width, int height);
+void Replay_RecordSpawn(Replay *replay, Vector2 position);
+void Replay_RecordBroadPhase(Replay *replay);
+void Replay_RecordNarrowPhase(Replay *replay);
+void Replay_RecordFrame(Replay *replay, float elapsedTime, int steps, Uint64 checksum);
+
+bool Replay_Open(Replay *replay, const char *path);
+bool Replay_Read(Replay *replay, ReplayEvent *event);
+
+void Replay_Close(Replay *replay);
+
+enum ReplayEventType
+{
+    ReplayEvent_Spawn,
+    ReplayEvent_BroadPhase,
+    ReplayEvent_NarrowPhase,
+    ReplayEvent_Frame,
+    ReplayEvent_Checksum
+};
+
+/*
+    One input of a recording. A Spawn (at x, y), a BroadPhase and a NarrowPhase
+    switch apply before the next Frame, which advances the world by elapsedTime.
+    A Checksum follows every Frame that took steps, the world checksum after them.
+*/
+struct ReplayEvent
+{
+    ReplayEventType type;
+
+    float x;
+    float y;
+    float elapsedTime;
+    Uint64 checksum;
+};
+
+/*
+    A recording: the header (magic, version, seed and window size) then one byte
+    of event type per event followed by its payload, little-endian. The engine
+    builds its world with Replay_ConfigureWorld and Replay_CreateScene and spawns
+    through Replay_Spawn from the seeded random state, so replaying the same inputs
+    with the same frame times reproduces every step.
+*/
+struct Replay
+{
+    FILE *file;
+
+    Uint32 seed;
+    int width;
+    int height;
+};
+
+#endif
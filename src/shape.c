@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shape.h"
+#include "collision.h"
+#include "alloc.h"
+
+static bool ShapeLibrary_Matches(ShapeLibrary *library, Shape *shape, ShapeType type, 
+                                float width, float height, float radius, Vector2 *vertices, int length)
+{
+    if (shape->type != type || shape->vertLength != length)
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+        case Box: return (shape->width == width && shape->height == height);
+        case Circle: return (shape->radius == radius);
+        case Polygon:
+            return (memcmp(&library->vertices[shape->vertexOffset], vertices, length * sizeof(Vector2)) == 0);
+    }
+
+    return false;
+}
+
+static int ShapeLibrary_Allocate(ShapeLibrary *library, int vertLength)
+{
+    for (int i = 0; i < library->length; ++i)
+    {
+        if (library->shapes[i].refCount == 0 && library->shapes[i].vertexCapacity >= vertLength)
+        {
+            return i;
+        }
+    }
+
+    if (library->length == library->capacity)
+    {
+        int capacity = (library->capacity > 0) ? library->capacity * 2 : 16;
+        Shape *temp = (Shape *)Alloc_Realloc(library->shapes, capacity * sizeof(Shape));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the shape library.\n");
+            return -1;
+        }
+
+        library->shapes = temp;
+        library->capacity = capacity;
+    }
+
+    if (library->vertexLength + vertLength > library->vertexCapacity)
+    {
+        int capacity = (library->vertexCapacity > 0) ? library->vertexCapacity : 64;
+
+        while (capacity < library->vertexLength + vertLength)
+        {
+            capacity *= 2;
+        }
+
+        Vector2 *temp = (Vector2 *)Alloc_Realloc(library->vertices, capacity * sizeof(Vector2));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the shape vertices.\n");
+            return -1;
+        }
+
+        library->vertices = temp;
+
+        temp = (Vector2 *)Alloc_Realloc(library->normals, capacity * sizeof(Vector2));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the shape normals.\n");
+            return -1;
+        }
+
+        library->normals = temp;
+        library->vertexCapacity = capacity;
+    }
+
+    int id = library->length++;
+
+    library->shapes[id].vertexOffset = library->vertexLength;
+    library->shapes[id].vertexCapacity = vertLength;
+    library->shapes[id].refCount = 0;
+    library->vertexLength += vertLength;
+
+    return id;
+}
+
+static int ShapeLibrary_Acquire(ShapeLibrary *library, ShapeType type, 
+                                float width, float height, float radius, Vector2 *vertices, int length)
+{
+    for (int i = 0; i < library->length; ++i)
+    {
+        Shape *shape = &library->shapes[i];
+
+        if (ShapeLibrary_Matches(library, shape, type, width, height, radius, vertices, length))
+        {
+            shape->refCount++;
+            return i;
+        }
+    }
+
+    int id = ShapeLibrary_Allocate(library, length);
+
+    if (id == -1)
+    {
+        return -1;
+    }
+
+    Shape *shape = &library->shapes[id];
+    shape->type = type;
+    shape->width = width;
+    shape->height = height;
+    shape->radius = radius;
+    shape->vertLength = length;
+    shape->refCount = 1;
+
+    Vector2_SetZero(&shape->centroid);
+    shape->boundingRadius = radius;
+
+    if (length > 0)
+    {
+        Vector2 *local = &library->vertices[shape->vertexOffset];
+        Vector2 *normals = &library->normals[shape->vertexOffset];
+
+        memcpy(local, vertices, length * sizeof(Vector2));
+        PolygonGetCenter(&shape->centroid, local, length);
+
+        for (int i = 0; i < length; ++i)
+        {
+            Vector2 edge;
+            Vector2_Sub(&edge, local[(i + 1) % length], local[i]);
+            Vector2_Normal(&normals[i], edge);
+            Vector2_Normalizedl(&normals[i]);
+
+            /* outward whatever the winding, the contact clipping relies on it */
+            Vector2 middle;
+            Vector2_Add(&middle, local[i], local[(i + 1) % length]);
+            Vector2_Multl(&middle, 0.5f);
+            Vector2_Subl(&middle, shape->centroid);
+
+            if (Vector2_Dot(normals[i], middle) < 0.0f)
+            {
+                Vector2_Multl(&normals[i], -1.0f);
+            }
+
+            Vector2 offset;
+            Vector2_Sub(&offset, local[i], shape->centroid);
+
+            float distance = Vector2_Length(offset);
+
+            if (distance > shape->boundingRadius)
+            {
+                shape->boundingRadius = distance;
+            }
+        }
+    }
+
+    return id;
+}
+
+void ShapeLibrary_Create(ShapeLibrary *library)
+{
+    library->shapes = NULL;
+    library->length = 0;
+    library->capacity = 0;
+
+    library->vertices = NULL;
+    library->normals = NULL;
+    library->vertexLength = 0;
+    library->vertexCapacity = 0;
+}
+
+int ShapeLibrary_AcquireBox(ShapeLibrary *library, float width, float height)
+{
+    Vector2 vertices[4] = {
+        {-width / 2.0f, -height / 2.0f},
+        { width / 2.0f, -height / 2.0f},
+        { width / 2.0f,  height / 2.0f},
+        {-width / 2.0f,  height / 2.0f}
+    };
+
+    return ShapeLibrary_Acquire(library, Box, width, height, 0.0f, vertices, 4);
+}
+
+int ShapeLibrary_AcquireCircle(ShapeLibrary *library, float radius)
+{
+    return ShapeLibrary_Acquire(library, Circle, 0.0f, 0.0f, radius, NULL, 0);
+}
+
+int ShapeLibrary_AcquirePolygon(ShapeLibrary *library, Vector2 *vertices, int length)
+{
+    if (length < 3 || length > SHAPE_MAX_VERTICES)
+    {
+        printf("Error polygon shapes need 3 to %i vertices.\n", SHAPE_MAX_VERTICES);
+        return -1;
+    }
+
+    return ShapeLibrary_Acquire(library, Polygon, 0.0f, 0.0f, 0.0f, vertices, length);
+}
+
+void ShapeLibrary_Retain(ShapeLibrary *library, int id)
+{
+    library->shapes[id].refCount++;
+}
+
+void ShapeLibrary_Release(ShapeLibrary *library, int id)
+{
+    if (library->shapes[id].refCount > 0)
+    {
+        library->shapes[id].refCount--;
+    }
+}
+
+void ShapeLibrary_Destroy(ShapeLibrary *library)
+{
+    Alloc_Free(library->shapes);
+    Alloc_Free(library->vertices);
+    Alloc_Free(library->normals);
+
+    ShapeLibrary_Create(library);
+}
+
+Shape *ShapeLibrary_Get(ShapeLibrary *library, int id)
+{
+    return &library->shapes[id];
+}
+
+Vector2 *ShapeLibrary_GetVertices(ShapeLibrary *library, int id)
+{
+    return &library->vertices[library->shapes[id].vertexOffset];
+}
+
+Vector2 *ShapeLibrary_GetNormals(ShapeLibrary *library, int id)
+{
+    return &library->normals[library->shapes[id].vertexOffset];
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef _SHAPE_H_
+#define _SHAPE_H_
+
+#include "types.h"
+#include <stdbool.h>
+
+typedef struct Shape                    Shape;
+typedef struct ShapeLibrary             ShapeLibrary;
+typedef enum   ShapeType                ShapeType;
+
+#define SHAPE_MAX_VERTICES 8
+
+void ShapeLibrary_Create(ShapeLibrary *library);
+int ShapeLibrary_AcquireBox(ShapeLibrary *library, float width, float height);
+int ShapeLibrary_AcquireCircle(ShapeLibrary *library, float radius);
+int ShapeLibrary_AcquirePolygon(ShapeLibrary *library, Vector2 *vertices, int length);
+void ShapeLibrary_Retain(ShapeLibrary *library, int id);
+void ShapeLibrary_Release(ShapeLibrary *library, int id);
+void ShapeLibrary_Destroy(ShapeLibrary *library);
+
+Shape *ShapeLibrary_Get(ShapeLibrary *library, int id);
+Vector2 *ShapeLibrary_GetVertices(ShapeLibrary *library, int id);
+Vector2 *ShapeLibrary_GetNormals(ShapeLibrary *library, int id);
+
+enum ShapeType 
+{
+    Box,
+    Circle,
+    Polygon
+};
+
+/*
+    Immutable local-space geometry shared by every body built from it.
+    vertices live in the library pool at vertexOffset, centered on the body
+    position; vertexCapacity is how much of the pool the slot owns. normals[i]
+    is the outward unit normal of the edge from vertex i to i + 1, boundingRadius the
+    radius of the circle around centroid holding every vertex.
+*/
+struct Shape
+{
+    ShapeType type;
+
+    float width;
+    float height;
+    float radius;
+
+    Vector2 centroid;
+    float boundingRadius;
+
+    int vertexOffset;
+    int vertLength;
+    int vertexCapacity;
+
+    int refCount;
+};
+
+/*
+    Released shapes keep their slot and geometry, acquiring the same shape again
+    revives it, otherwise the slot is reused by a shape that fits in its vertices.
+*/
+struct ShapeLibrary
+{
+    Shape *shapes;
+    int length;
+    int capacity;
+
+    Vector2 *vertices;
+    Vector2 *normals;
+    int vertexLength;
+    int vertexCapacity;
+};
+
+#endif
\ No newline at end of file
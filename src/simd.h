@@ -0,0 +1,17 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+/*
+    Picks the widest instruction set the compiler was told about. SSE2 is always
+    there on x86-64, AVX2 needs -mavx2; anything else takes the scalar paths.
+*/
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SIMD_AVX2
+    #define SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SIMD_SSE2
+#endif
+
+#endif
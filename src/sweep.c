@@ -0,0 +1,493 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include "broadphase.h"
+#include "body.h"
+#include "alloc.h"
+
+#define SWEEP_EMPTY_KEY UINT64_MAX
+
+static Uint64 Sweep_Key(int a, int b)
+{
+    return ((Uint64)(Uint32)a << 32) | (Uint64)(Uint32)b;
+}
+
+static Uint32 Sweep_Hash(Uint64 key, int capacity)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+
+    return (Uint32)key & (Uint32)(capacity - 1);
+}
+
+static bool Sweep_Less(SweepEndpoint a, SweepEndpoint b)
+{
+    /* min before max on ties, touching boxes count as overlapping like AABB_Overlap */
+    return (a.value < b.value || (a.value == b.value && !a.isMax && b.isMax));
+}
+
+static int Sweep_Find(SweepAndPrune *sap, Uint64 key)
+{
+    if (sap->keyCapacity == 0)
+    {
+        return -1;
+    }
+
+    int mask = sap->keyCapacity - 1;
+    int slot = Sweep_Hash(key, sap->keyCapacity);
+
+    while (sap->keys[slot] != SWEEP_EMPTY_KEY)
+    {
+        if (sap->keys[slot] == key)
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return -1;
+}
+
+static void Sweep_Place(SweepAndPrune *sap, Uint64 key, int pair)
+{
+    int mask = sap->keyCapacity - 1;
+    int slot = Sweep_Hash(key, sap->keyCapacity);
+
+    while (sap->keys[slot] != SWEEP_EMPTY_KEY)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    sap->keys[slot] = key;
+    sap->slots[slot] = pair;
+}
+
+static void Sweep_Reindex(SweepAndPrune *sap)
+{
+    for (int i = 0; i < sap->keyCapacity; ++i)
+    {
+        sap->keys[i] = SWEEP_EMPTY_KEY;
+    }
+
+    for (int i = 0; i < sap->pairLength; ++i)
+    {
+        Sweep_Place(sap, Sweep_Key(sap->pairs[i].a, sap->pairs[i].b), i);
+    }
+}
+
+static bool Sweep_GrowPairs(SweepAndPrune *sap, int capacity)
+{
+    BodyPair *temp = (BodyPair *)Alloc_Realloc(sap->pairs, capacity * sizeof(BodyPair));
+
+    if (temp == NULL)
+    {
+        printf("Error when growing the pair list.\n");
+        return false;
+    }
+
+    sap->pairs = temp;
+    sap->pairCapacity = capacity;
+
+    return true;
+}
+
+static bool Sweep_GrowEndpoints(SweepAndPrune *sap, int capacity)
+{
+    for (int a = 0; a < 2; ++a)
+    {
+        SweepEndpoint *temp = (SweepEndpoint *)Alloc_Realloc(sap->axis[a], capacity * sizeof(SweepEndpoint));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the sweep endpoints.\n");
+            return false;
+        }
+
+        sap->axis[a] = temp;
+    }
+
+    sap->endpointCapacity = capacity;
+
+    return true;
+}
+
+static bool Sweep_Rehash(SweepAndPrune *sap, int capacity)
+{
+    Uint64 *keys = (Uint64 *)Alloc_Malloc(capacity * sizeof(Uint64));
+    int *slots = (int *)Alloc_Malloc(capacity * sizeof(int));
+
+    if (keys == NULL || slots == NULL)
+    {
+        printf("Error when growing the pair set.\n");
+        Alloc_Free(keys);
+        Alloc_Free(slots);
+        return false;
+    }
+
+    Alloc_Free(sap->keys);
+    Alloc_Free(sap->slots);
+
+    sap->keys = keys;
+    sap->slots = slots;
+    sap->keyCapacity = capacity;
+
+    Sweep_Reindex(sap);
+
+    return true;
+}
+
+static void Sweep_AddPair(SweepAndPrune *sap, int a, int b)
+{
+    if (a > b)
+    {
+        int temp = a;
+        a = b;
+        b = temp;
+    }
+
+    Uint64 key = Sweep_Key(a, b);
+
+    if (Sweep_Find(sap, key) != -1)
+    {
+        return;
+    }
+
+    if (sap->pairLength == sap->pairCapacity)
+    {
+        if (!Sweep_GrowPairs(sap, (sap->pairCapacity > 0) ? sap->pairCapacity * 2 : 64))
+        {
+            return;
+        }
+    }
+
+    if ((sap->pairLength + 1) * 2 > sap->keyCapacity)
+    {
+        if (!Sweep_Rehash(sap, (sap->keyCapacity > 0) ? sap->keyCapacity * 2 : 128))
+        {
+            return;
+        }
+    }
+
+    BodyPair pair = {a, b};
+    sap->pairs[sap->pairLength] = pair;
+    Sweep_Place(sap, key, sap->pairLength);
+
+    sap->pairLength++;
+    sap->addedPairs++;
+}
+
+static void Sweep_RemovePair(SweepAndPrune *sap, int a, int b)
+{
+    if (a > b)
+    {
+        int temp = a;
+        a = b;
+        b = temp;
+    }
+
+    int slot = Sweep_Find(sap, Sweep_Key(a, b));
+
+    if (slot == -1)
+    {
+        return;
+    }
+
+    /* swap the last pair into the hole of the dense list */
+    int hole = sap->slots[slot];
+    int last = sap->pairLength - 1;
+
+    if (hole != last)
+    {
+        BodyPair moved = sap->pairs[last];
+        sap->pairs[hole] = moved;
+        sap->slots[Sweep_Find(sap, Sweep_Key(moved.a, moved.b))] = hole;
+    }
+
+    sap->pairLength--;
+    sap->removedPairs++;
+
+    /* backward shift deletion keeps the probe chains intact without tombstones */
+    int mask = sap->keyCapacity - 1;
+    int i = slot;
+    int j = slot;
+
+    while (true)
+    {
+        j = (j + 1) & mask;
+
+        if (sap->keys[j] == SWEEP_EMPTY_KEY)
+        {
+            break;
+        }
+
+        int k = Sweep_Hash(sap->keys[j], sap->keyCapacity);
+
+        if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j)))
+        {
+            sap->keys[i] = sap->keys[j];
+            sap->slots[i] = sap->slots[j];
+            i = j;
+        }
+    }
+
+    sap->keys[i] = SWEEP_EMPTY_KEY;
+}
+
+static void Sweep_SortAxis(SweepAndPrune *sap, BodyList *bodies, SweepEndpoint *axis)
+{
+    for (int i = 1; i < sap->endpointLength; ++i)
+    {
+        SweepEndpoint key = axis[i];
+        int j = i - 1;
+
+        while (j >= 0 && Sweep_Less(key, axis[j]))
+        {
+            SweepEndpoint *other = &axis[j];
+
+            if (key.body != other->body)
+            {
+                Body *b0 = &bodies->bodies[key.body];
+                Body *b1 = &bodies->bodies[other->body];
+
+                if (!key.isMax && other->isMax)
+                {
+                    if (!(b0->isStatic && b1->isStatic) && AABB_Overlap(b0->aabb, b1->aabb))
+                    {
+                        Sweep_AddPair(sap, key.body, other->body);
+                    }
+                }
+                else if (key.isMax && !other->isMax)
+                {
+                    Sweep_RemovePair(sap, key.body, other->body);
+                }
+            }
+
+            axis[j + 1] = axis[j];
+            --j;
+        }
+
+        axis[j + 1] = key;
+    }
+}
+
+void SweepAndPrune_Create(SweepAndPrune *sap)
+{
+    sap->axis[0] = NULL;
+    sap->axis[1] = NULL;
+    sap->endpointLength = 0;
+    sap->endpointCapacity = 0;
+
+    sap->keys = NULL;
+    sap->slots = NULL;
+    sap->keyCapacity = 0;
+
+    sap->pairs = NULL;
+    sap->pairLength = 0;
+    sap->pairCapacity = 0;
+
+    sap->addedPairs = 0;
+    sap->removedPairs = 0;
+}
+
+void SweepAndPrune_Insert(SweepAndPrune *sap, BodyList *bodies, int index)
+{
+    (void)bodies;
+
+    if (sap->endpointLength + 2 > sap->endpointCapacity)
+    {
+        if (!Sweep_GrowEndpoints(sap, (sap->endpointCapacity > 0) ? sap->endpointCapacity * 2 : 128))
+        {
+            return;
+        }
+    }
+
+    /*
+        New endpoints start at the far end of both axes, the next update sorts them
+        into place and the swaps on the way produce the initial pair events.
+    */
+    for (int a = 0; a < 2; ++a)
+    {
+        SweepEndpoint min = {FLT_MAX, index, false};
+        SweepEndpoint max = {FLT_MAX, index, true};
+
+        sap->axis[a][sap->endpointLength] = min;
+        sap->axis[a][sap->endpointLength + 1] = max;
+    }
+
+    sap->endpointLength += 2;
+}
+
+void SweepAndPrune_Remove(SweepAndPrune *sap, BodyList *bodies, int index)
+{
+    /* BodyList_Remove swaps the last body into the hole, follow it */
+    int last = bodies->length - 1;
+
+    for (int a = 0; a < 2; ++a)
+    {
+        int length = 0;
+
+        for (int i = 0; i < sap->endpointLength; ++i)
+        {
+            SweepEndpoint endpoint = sap->axis[a][i];
+
+            if (endpoint.body == index)
+            {
+                continue;
+            }
+
+            if (endpoint.body == last)
+            {
+                endpoint.body = index;
+            }
+
+            sap->axis[a][length++] = endpoint;
+        }
+    }
+
+    sap->endpointLength -= 2;
+
+    int length = 0;
+
+    for (int i = 0; i < sap->pairLength; ++i)
+    {
+        BodyPair pair = sap->pairs[i];
+
+        if (pair.a == index || pair.b == index)
+        {
+            sap->removedPairs++;
+            continue;
+        }
+
+        if (pair.a == last) pair.a = index;
+        if (pair.b == last) pair.b = index;
+
+        if (pair.a > pair.b)
+        {
+            int temp = pair.a;
+            pair.a = pair.b;
+            pair.b = temp;
+        }
+
+        sap->pairs[length++] = pair;
+    }
+
+    sap->pairLength = length;
+
+    Sweep_Reindex(sap);
+}
+
+void SweepAndPrune_Compact(SweepAndPrune *sap, const int *remap, int length)
+{
+    (void)length;
+
+    int endpointLength = 0;
+
+    for (int a = 0; a < 2; ++a)
+    {
+        endpointLength = 0;
+
+        for (int i = 0; i < sap->endpointLength; ++i)
+        {
+            SweepEndpoint endpoint = sap->axis[a][i];
+
+            if (remap[endpoint.body] == -1)
+            {
+                continue;
+            }
+
+            endpoint.body = remap[endpoint.body];
+            sap->axis[a][endpointLength++] = endpoint;
+        }
+    }
+
+    sap->endpointLength = endpointLength;
+
+    /* remap keeps the order of the survivors, so pair.a < pair.b still holds */
+    int pairLength = 0;
+
+    for (int i = 0; i < sap->pairLength; ++i)
+    {
+        BodyPair pair = sap->pairs[i];
+
+        if (remap[pair.a] == -1 || remap[pair.b] == -1)
+        {
+            sap->removedPairs++;
+            continue;
+        }
+
+        pair.a = remap[pair.a];
+        pair.b = remap[pair.b];
+
+        sap->pairs[pairLength++] = pair;
+    }
+
+    sap->pairLength = pairLength;
+
+    Sweep_Reindex(sap);
+}
+
+void SweepAndPrune_Reserve(SweepAndPrune *sap, int capacity)
+{
+    if (capacity * 2 > sap->endpointCapacity)
+    {
+        Sweep_GrowEndpoints(sap, capacity * 2);
+    }
+
+    if (capacity > sap->pairCapacity)
+    {
+        Sweep_GrowPairs(sap, capacity);
+    }
+
+    int keyCapacity = (sap->keyCapacity > 0) ? sap->keyCapacity : 128;
+
+    while (keyCapacity < capacity * 2)
+    {
+        keyCapacity *= 2;
+    }
+
+    if (keyCapacity > sap->keyCapacity)
+    {
+        Sweep_Rehash(sap, keyCapacity);
+    }
+}
+
+void SweepAndPrune_Update(SweepAndPrune *sap, BodyList *bodies)
+{
+    sap->addedPairs = 0;
+    sap->removedPairs = 0;
+
+    for (int a = 0; a < 2; ++a)
+    {
+        for (int i = 0; i < sap->endpointLength; ++i)
+        {
+            SweepEndpoint *endpoint = &sap->axis[a][i];
+            endpoint->value = bodies->bodies[endpoint->body].aabb[endpoint->isMax][a];
+        }
+    }
+
+    Sweep_SortAxis(sap, bodies, sap->axis[0]);
+    Sweep_SortAxis(sap, bodies, sap->axis[1]);
+}
+
+void SweepAndPrune_FindPairs(SweepAndPrune *sap, BodyList *bodies, PairList *pairs)
+{
+    (void)bodies;
+
+    for (int i = 0; i < sap->pairLength; ++i)
+    {
+        PairList_Push(pairs, sap->pairs[i].a, sap->pairs[i].b);
+    }
+}
+
+void SweepAndPrune_Destroy(SweepAndPrune *sap)
+{
+    Alloc_Free(sap->axis[0]);
+    Alloc_Free(sap->axis[1]);
+    Alloc_Free(sap->keys);
+    Alloc_Free(sap->slots);
+    Alloc_Free(sap->pairs);
+
+    SweepAndPrune_Create(sap);
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include "threadpool.h"
+#include "alloc.h"
+
+static void *ThreadPool_Main(void *arg)
+{
+    ThreadPoolWorker *worker = (ThreadPoolWorker *)arg;
+    ThreadPool *pool = worker->pool;
+    Uint32 generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (true)
+    {
+        while (!pool->quit && pool->generation == generation)
+        {
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        }
+
+        if (pool->quit)
+        {
+            break;
+        }
+
+        generation = pool->generation;
+        ThreadPoolJob job = pool->job;
+        void *data = pool->data;
+
+        pthread_mutex_unlock(&pool->mutex);
+        job(data, worker->index, pool->count);
+        pthread_mutex_lock(&pool->mutex);
+
+        if (--pool->pending == 0)
+        {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+bool ThreadPool_Create(ThreadPool *pool, int count)
+{
+    if (count < 1) count = 1;
+    if (count > THREADPOOL_MAX_WORKERS) count = THREADPOOL_MAX_WORKERS;
+
+    pool->workers = NULL;
+    pool->count = 1;
+    pool->job = NULL;
+    pool->data = NULL;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->quit = false;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    if (count == 1)
+    {
+        return true;
+    }
+
+    pool->workers = (ThreadPoolWorker *)Alloc_Malloc(count * sizeof(ThreadPoolWorker));
+
+    if (pool->workers == NULL)
+    {
+        printf("Error when creating the thread pool.\n");
+        return false;
+    }
+
+    for (int i = 1; i < count; ++i)
+    {
+        ThreadPoolWorker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+
+        if (pthread_create(&worker->thread, NULL, ThreadPool_Main, worker) != 0)
+        {
+            printf("Error when starting worker %i, running with %i.\n", i, pool->count);
+            break;
+        }
+
+        pool->count++;
+    }
+
+    return true;
+}
+
+void ThreadPool_Run(ThreadPool *pool, ThreadPoolJob job, void *data)
+{
+    if (pool->count == 1)
+    {
+        job(data, 0, 1);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->data = data;
+    pool->pending = pool->count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    job(data, 0, pool->count);
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (pool->pending > 0)
+    {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void ThreadPool_Destroy(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 1; i < pool->count; ++i)
+    {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    Alloc_Free(pool->workers);
+    pool->workers = NULL;
+    pool->count = 1;
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+}
@@ -0,0 +1,48 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include "types.h"
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct ThreadPool               ThreadPool;
+typedef struct ThreadPoolWorker         ThreadPoolWorker;
+
+#define THREADPOOL_MAX_WORKERS  64
+
+/* job(data, worker, workerCount), called once per worker for every run */
+typedef void (*ThreadPoolJob)(void *data, int worker, int workerCount);
+
+bool ThreadPool_Create(ThreadPool *pool, int count);
+void ThreadPool_Run(ThreadPool *pool, ThreadPoolJob job, void *data);
+void ThreadPool_Destroy(ThreadPool *pool);
+
+struct ThreadPoolWorker
+{
+    ThreadPool *pool;
+    pthread_t thread;
+    int index;
+};
+
+/*
+    Persistent workers woken once per run. count includes the calling thread, which
+    runs worker 0 itself, so a pool of 1 never starts a thread. generation is bumped
+    for every run and pending counts the workers that have not finished it.
+*/
+struct ThreadPool
+{
+    ThreadPoolWorker *workers;
+    int count;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    ThreadPoolJob job;
+    void *data;
+    Uint32 generation;
+    int pending;
+    bool quit;
+};
+
+#endif
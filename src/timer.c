@@ -0,0 +1,10 @@
+#include <time.h>
+#include "timer.h"
+
+Uint64 Timer_Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (Uint64)now.tv_sec * 1000000000ull + (Uint64)now.tv_nsec;
+}
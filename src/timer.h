@@ -0,0 +1,9 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include "types.h"
+
+/* monotonic clock in nanoseconds, only differences are meaningful */
+Uint64 Timer_Now(void);
+
+#endif
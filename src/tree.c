@@ -0,0 +1,549 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "broadphase.h"
+#include "body.h"
+#include "alloc.h"
+
+static bool Tree_GrowNodes(DynamicTree *tree, int capacity)
+{
+    TreeNode *temp = (TreeNode *)Alloc_Realloc(tree->nodes, capacity * sizeof(TreeNode));
+
+    if (temp == NULL)
+    {
+        printf("Error when growing the tree nodes.\n");
+        return false;
+    }
+
+    tree->nodes = temp;
+
+    /* the new nodes are chained in front of whatever is still free */
+    for (int i = tree->nodeCapacity; i < capacity; ++i)
+    {
+        tree->nodes[i].parent = (i + 1 < capacity) ? i + 1 : tree->freeList;
+        tree->nodes[i].height = -1;
+    }
+
+    tree->freeList = tree->nodeCapacity;
+    tree->nodeCapacity = capacity;
+
+    return true;
+}
+
+static bool Tree_GrowLeaves(DynamicTree *tree, int capacity)
+{
+    int *temp = (int *)Alloc_Realloc(tree->leaves, capacity * sizeof(int));
+
+    if (temp == NULL)
+    {
+        printf("Error when growing the tree leaves.\n");
+        return false;
+    }
+
+    tree->leaves = temp;
+    tree->leafCapacity = capacity;
+
+    return true;
+}
+
+static int Tree_AllocateNode(DynamicTree *tree)
+{
+    if (tree->freeList == TREE_NULL_NODE)
+    {
+        int capacity = (tree->nodeCapacity > 0) ? tree->nodeCapacity * 2 : 64;
+
+        if (!Tree_GrowNodes(tree, capacity))
+        {
+            return TREE_NULL_NODE;
+        }
+    }
+
+    int node = tree->freeList;
+    tree->freeList = tree->nodes[node].parent;
+
+    tree->nodes[node].parent = TREE_NULL_NODE;
+    tree->nodes[node].child0 = TREE_NULL_NODE;
+    tree->nodes[node].child1 = TREE_NULL_NODE;
+    tree->nodes[node].height = 0;
+    tree->nodes[node].body = -1;
+
+    return node;
+}
+
+static void Tree_FreeNode(DynamicTree *tree, int node)
+{
+    tree->nodes[node].parent = tree->freeList;
+    tree->nodes[node].height = -1;
+    tree->freeList = node;
+}
+
+static bool Tree_IsLeaf(TreeNode *node)
+{
+    return (node->child0 == TREE_NULL_NODE);
+}
+
+static int Tree_Max(int a, int b)
+{
+    return (a > b) ? a : b;
+}
+
+/*
+    AVL style rotation, promotes the taller grandchild when the subtree
+    under index is unbalanced by more than one level.
+*/
+static int Tree_Balance(DynamicTree *tree, int iA)
+{
+    TreeNode *A = &tree->nodes[iA];
+
+    if (Tree_IsLeaf(A) || A->height < 2)
+    {
+        return iA;
+    }
+
+    int iB = A->child0;
+    int iC = A->child1;
+    TreeNode *B = &tree->nodes[iB];
+    TreeNode *C = &tree->nodes[iC];
+
+    int balance = C->height - B->height;
+
+    if (balance > 1)
+    {
+        int iF = C->child0;
+        int iG = C->child1;
+        TreeNode *F = &tree->nodes[iF];
+        TreeNode *G = &tree->nodes[iG];
+
+        C->child0 = iA;
+        C->parent = A->parent;
+        A->parent = iC;
+
+        if (C->parent != TREE_NULL_NODE)
+        {
+            if (tree->nodes[C->parent].child0 == iA) tree->nodes[C->parent].child0 = iC;
+            else tree->nodes[C->parent].child1 = iC;
+        }
+        else
+        {
+            tree->root = iC;
+        }
+
+        if (F->height > G->height)
+        {
+            C->child1 = iF;
+            A->child1 = iG;
+            G->parent = iA;
+            AABB_Combine(&A->aabb, B->aabb, G->aabb);
+            AABB_Combine(&C->aabb, A->aabb, F->aabb);
+
+            A->height = 1 + Tree_Max(B->height, G->height);
+            C->height = 1 + Tree_Max(A->height, F->height);
+        }
+        else
+        {
+            C->child1 = iG;
+            A->child1 = iF;
+            F->parent = iA;
+            AABB_Combine(&A->aabb, B->aabb, F->aabb);
+            AABB_Combine(&C->aabb, A->aabb, G->aabb);
+
+            A->height = 1 + Tree_Max(B->height, F->height);
+            C->height = 1 + Tree_Max(A->height, G->height);
+        }
+
+        return iC;
+    }
+
+    if (balance < -1)
+    {
+        int iD = B->child0;
+        int iE = B->child1;
+        TreeNode *D = &tree->nodes[iD];
+        TreeNode *E = &tree->nodes[iE];
+
+        B->child0 = iA;
+        B->parent = A->parent;
+        A->parent = iB;
+
+        if (B->parent != TREE_NULL_NODE)
+        {
+            if (tree->nodes[B->parent].child0 == iA) tree->nodes[B->parent].child0 = iB;
+            else tree->nodes[B->parent].child1 = iB;
+        }
+        else
+        {
+            tree->root = iB;
+        }
+
+        if (D->height > E->height)
+        {
+            B->child1 = iD;
+            A->child0 = iE;
+            E->parent = iA;
+            AABB_Combine(&A->aabb, C->aabb, E->aabb);
+            AABB_Combine(&B->aabb, A->aabb, D->aabb);
+
+            A->height = 1 + Tree_Max(C->height, E->height);
+            B->height = 1 + Tree_Max(A->height, D->height);
+        }
+        else
+        {
+            B->child1 = iE;
+            A->child0 = iD;
+            D->parent = iA;
+            AABB_Combine(&A->aabb, C->aabb, D->aabb);
+            AABB_Combine(&B->aabb, A->aabb, E->aabb);
+
+            A->height = 1 + Tree_Max(C->height, D->height);
+            B->height = 1 + Tree_Max(A->height, E->height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+static void Tree_Refit(DynamicTree *tree, int index)
+{
+    while (index != TREE_NULL_NODE)
+    {
+        index = Tree_Balance(tree, index);
+
+        TreeNode *node = &tree->nodes[index];
+        TreeNode *child0 = &tree->nodes[node->child0];
+        TreeNode *child1 = &tree->nodes[node->child1];
+
+        node->height = 1 + Tree_Max(child0->height, child1->height);
+        AABB_Combine(&node->aabb, child0->aabb, child1->aabb);
+
+        index = node->parent;
+    }
+}
+
+static void Tree_InsertLeaf(DynamicTree *tree, int leaf)
+{
+    if (tree->root == TREE_NULL_NODE)
+    {
+        tree->root = leaf;
+        tree->nodes[leaf].parent = TREE_NULL_NODE;
+        return;
+    }
+
+    /*
+        Walk down picking the child with the cheapest perimeter growth,
+        stop when making a new parent here is cheaper than descending.
+    */
+    AABB leafAABB;
+    AABB_Setv(&leafAABB, tree->nodes[leaf].aabb[0], tree->nodes[leaf].aabb[1]);
+
+    int index = tree->root;
+
+    while (!Tree_IsLeaf(&tree->nodes[index]))
+    {
+        TreeNode *node = &tree->nodes[index];
+        float area = AABB_Perimeter(node->aabb);
+
+        AABB combined;
+        AABB_Combine(&combined, node->aabb, leafAABB);
+        float combinedArea = AABB_Perimeter(combined);
+
+        float cost = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - area);
+
+        float costs[2];
+        int children[2] = {node->child0, node->child1};
+
+        for (int i = 0; i < 2; ++i)
+        {
+            TreeNode *child = &tree->nodes[children[i]];
+            AABB_Combine(&combined, child->aabb, leafAABB);
+
+            if (Tree_IsLeaf(child))
+            {
+                costs[i] = AABB_Perimeter(combined) + inheritance;
+            }
+            else
+            {
+                costs[i] = (AABB_Perimeter(combined) - AABB_Perimeter(child->aabb)) + inheritance;
+            }
+        }
+
+        if (cost < costs[0] && cost < costs[1])
+        {
+            break;
+        }
+
+        index = (costs[0] < costs[1]) ? children[0] : children[1];
+    }
+
+    int sibling = index;
+    int oldParent = tree->nodes[sibling].parent;
+    int newParent = Tree_AllocateNode(tree);
+
+    tree->nodes[newParent].parent = oldParent;
+    tree->nodes[newParent].height = tree->nodes[sibling].height + 1;
+    AABB_Combine(&tree->nodes[newParent].aabb, leafAABB, tree->nodes[sibling].aabb);
+
+    if (oldParent != TREE_NULL_NODE)
+    {
+        if (tree->nodes[oldParent].child0 == sibling) tree->nodes[oldParent].child0 = newParent;
+        else tree->nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        tree->root = newParent;
+    }
+
+    tree->nodes[newParent].child0 = sibling;
+    tree->nodes[newParent].child1 = leaf;
+    tree->nodes[sibling].parent = newParent;
+    tree->nodes[leaf].parent = newParent;
+
+    Tree_Refit(tree, tree->nodes[leaf].parent);
+}
+
+static void Tree_RemoveLeaf(DynamicTree *tree, int leaf)
+{
+    if (leaf == tree->root)
+    {
+        tree->root = TREE_NULL_NODE;
+        return;
+    }
+
+    int parent = tree->nodes[leaf].parent;
+    int grandParent = tree->nodes[parent].parent;
+    int sibling = (tree->nodes[parent].child0 == leaf) ? tree->nodes[parent].child1 : tree->nodes[parent].child0;
+
+    if (grandParent != TREE_NULL_NODE)
+    {
+        if (tree->nodes[grandParent].child0 == parent) tree->nodes[grandParent].child0 = sibling;
+        else tree->nodes[grandParent].child1 = sibling;
+
+        tree->nodes[sibling].parent = grandParent;
+        Tree_FreeNode(tree, parent);
+
+        Tree_Refit(tree, grandParent);
+    }
+    else
+    {
+        tree->root = sibling;
+        tree->nodes[sibling].parent = TREE_NULL_NODE;
+        Tree_FreeNode(tree, parent);
+    }
+}
+
+static void Tree_SetFatAABB(DynamicTree *tree, int node, Body *body)
+{
+    float margin = (body->isStatic) ? 0.0f : TREE_AABB_MARGIN;
+
+    AABB_Set(&tree->nodes[node].aabb,
+            body->aabb[0][0] - margin, body->aabb[0][1] - margin,
+            body->aabb[1][0] + margin, body->aabb[1][1] + margin);
+}
+
+static bool Tree_Push(DynamicTree *tree, int *top, int node)
+{
+    if (*top == tree->stackCapacity)
+    {
+        int capacity = (tree->stackCapacity > 0) ? tree->stackCapacity * 2 : 64;
+        int *temp = (int *)Alloc_Realloc(tree->stack, capacity * sizeof(int));
+
+        if (temp == NULL)
+        {
+            printf("Error when growing the tree stack.\n");
+            return false;
+        }
+
+        tree->stack = temp;
+        tree->stackCapacity = capacity;
+    }
+
+    tree->stack[(*top)++] = node;
+    return true;
+}
+
+void DynamicTree_Create(DynamicTree *tree)
+{
+    tree->nodes = NULL;
+    tree->nodeCapacity = 0;
+    tree->freeList = TREE_NULL_NODE;
+    tree->root = TREE_NULL_NODE;
+
+    tree->leaves = NULL;
+    tree->leafCapacity = 0;
+
+    tree->stack = NULL;
+    tree->stackCapacity = 0;
+}
+
+void DynamicTree_Insert(DynamicTree *tree, BodyList *bodies, int index)
+{
+    if (index >= tree->leafCapacity)
+    {
+        int capacity = (tree->leafCapacity > 0) ? tree->leafCapacity : 64;
+
+        while (capacity <= index)
+        {
+            capacity *= 2;
+        }
+
+        if (!Tree_GrowLeaves(tree, capacity))
+        {
+            return;
+        }
+    }
+
+    int leaf = Tree_AllocateNode(tree);
+
+    if (leaf == TREE_NULL_NODE)
+    {
+        return;
+    }
+
+    tree->nodes[leaf].body = index;
+    Tree_SetFatAABB(tree, leaf, &bodies->bodies[index]);
+    Tree_InsertLeaf(tree, leaf);
+
+    tree->leaves[index] = leaf;
+}
+
+void DynamicTree_Remove(DynamicTree *tree, BodyList *bodies, int index)
+{
+    int leaf = tree->leaves[index];
+
+    Tree_RemoveLeaf(tree, leaf);
+    Tree_FreeNode(tree, leaf);
+
+    /* BodyList_Remove swaps the last body into the hole, follow it */
+    int last = bodies->length - 1;
+
+    if (index != last)
+    {
+        tree->leaves[index] = tree->leaves[last];
+        tree->nodes[tree->leaves[index]].body = index;
+    }
+}
+
+void DynamicTree_Compact(DynamicTree *tree, const int *remap, int length)
+{
+    /* the compaction is stable, remap[i] <= i so leaves[] can be shifted in place */
+    for (int i = 0; i < length; ++i)
+    {
+        int leaf = tree->leaves[i];
+
+        if (remap[i] == -1)
+        {
+            Tree_RemoveLeaf(tree, leaf);
+            Tree_FreeNode(tree, leaf);
+        }
+        else
+        {
+            tree->leaves[remap[i]] = leaf;
+            tree->nodes[leaf].body = remap[i];
+        }
+    }
+}
+
+void DynamicTree_Reserve(DynamicTree *tree, int capacity)
+{
+    if (capacity > tree->leafCapacity)
+    {
+        Tree_GrowLeaves(tree, capacity);
+    }
+
+    /* n leaves never need more than 2n - 1 nodes */
+    if (capacity * 2 > tree->nodeCapacity)
+    {
+        Tree_GrowNodes(tree, capacity * 2);
+    }
+}
+
+void DynamicTree_Update(DynamicTree *tree, BodyList *bodies)
+{
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *body = &bodies->bodies[i];
+        int leaf = tree->leaves[i];
+
+        if (body->isStatic || AABB_Contains(tree->nodes[leaf].aabb, body->aabb))
+        {
+            continue;
+        }
+
+        Tree_RemoveLeaf(tree, leaf);
+        Tree_SetFatAABB(tree, leaf, body);
+        Tree_InsertLeaf(tree, leaf);
+    }
+}
+
+void DynamicTree_FindPairs(DynamicTree *tree, BodyList *bodies, PairList *pairs)
+{
+    if (tree->root == TREE_NULL_NODE)
+    {
+        return;
+    }
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *b0 = &bodies->bodies[i];
+
+        if (b0->isStatic)
+        {
+            continue;
+        }
+
+        int top = 0;
+        Tree_Push(tree, &top, tree->root);
+
+        while (top > 0)
+        {
+            TreeNode *node = &tree->nodes[tree->stack[--top]];
+
+            if (!AABB_Overlap(node->aabb, b0->aabb))
+            {
+                continue;
+            }
+
+            if (!Tree_IsLeaf(node))
+            {
+                Tree_Push(tree, &top, node->child0);
+                Tree_Push(tree, &top, node->child1);
+                continue;
+            }
+
+            int j = node->body;
+            Body *b1 = &bodies->bodies[j];
+
+            /* static bodies never query, dynamic pairs are reported by the lower index */
+            if (j == i || (!b1->isStatic && j < i))
+            {
+                continue;
+            }
+
+            if (AABB_Overlap(b0->aabb, b1->aabb))
+            {
+                PairList_Push(pairs, (i < j) ? i : j, (i < j) ? j : i);
+            }
+        }
+    }
+}
+
+void DynamicTree_Destroy(DynamicTree *tree)
+{
+    if (tree->nodes != NULL)
+    {
+        Alloc_Free(tree->nodes);
+    }
+
+    if (tree->leaves != NULL)
+    {
+        Alloc_Free(tree->leaves);
+    }
+
+    if (tree->stack != NULL)
+    {
+        Alloc_Free(tree->stack);
+    }
+
+    DynamicTree_Create(tree);
+}
\ No newline at end of file
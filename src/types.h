@@ -2,7 +2,9 @@
 #define _TYPES_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
+typedef uint64_t Uint64;
 typedef uint32_t Uint32;
 typedef uint16_t Uint16;
 typedef uint8_t Uint8;
@@ -47,6 +49,11 @@ float Vector2_Dot(Vector2 a, Vector2 b);
 
 void AABB_Set(AABB *aabb, float minX, float minY, float maxX, float maxY);
 void AABB_Setv(AABB *aabb, Vector2 min, Vector2 max);
+void AABB_Combine(AABB *result, AABB a, AABB b);
+
+bool AABB_Overlap(AABB a, AABB b);
+bool AABB_Contains(AABB outer, AABB inner);
+float AABB_Perimeter(AABB aabb);
 
 void Transform_Set(Transform *transform, float x, float y, float angle);
 void Transform_Setv(Transform *transform, Vector2 v, float angle);
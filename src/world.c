@@ -2,14 +2,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 #include "world.h"
 #include "body.h"
-#include "engine.h"
 #include "collision.h"
+#include "alloc.h"
+#include "timer.h"
 
 void World_Create(World **world, Vector2 gravity)
 {
-    (*world) = (World *)malloc(sizeof(World));
+    (*world) = (World *)Alloc_Malloc(sizeof(World));
 
     if (*world == NULL)
     {
@@ -17,8 +19,76 @@ void World_Create(World **world, Vector2 gravity)
         return;
     }
 
-    BodyList_Create(&(*world)->bodies);
+    ShapeLibrary_Create(&(*world)->shapes);
+    BodyList_Create(&(*world)->bodies, &(*world)->shapes);
     Vector2_Setv(&(*world)->gravity, gravity);
+
+    BroadPhase_Create(&(*world)->broadPhase, BroadPhase_Grid);
+    PairList_Create(&(*world)->pairs);
+
+    ThreadPool_Create(&(*world)->threads, 1);
+    ContactList_Create(&(*world)->contacts);
+
+    for (int i = 0; i < THREADPOOL_MAX_WORKERS; ++i)
+    {
+        ContactList_Create(&(*world)->threadContacts[i]);
+    }
+
+    (*world)->activeThreads = 1;
+
+    ContactCache_Create(&(*world)->contactCache);
+    (*world)->velocityIterations = WORLD_VELOCITY_ITERATIONS;
+
+    (*world)->parallelResolve = false;
+    (*world)->colored = false;
+    (*world)->batchFunction = NULL;
+    (*world)->bodyColors = NULL;
+    (*world)->bodyColorCapacity = 0;
+    (*world)->contactColors = NULL;
+    (*world)->contactColorCapacity = 0;
+    ContactList_Create(&(*world)->coloredContacts);
+
+    (*world)->sleeping = false;
+    (*world)->sleepLinearVelocity = WORLD_SLEEP_LINEAR_VELOCITY;
+    (*world)->sleepAngularVelocity = WORLD_SLEEP_ANGULAR_VELOCITY;
+    (*world)->timeToSleep = WORLD_TIME_TO_SLEEP;
+    (*world)->islandParent = NULL;
+    (*world)->islandTime = NULL;
+    (*world)->maxSpeed = NULL;
+    (*world)->islandCapacity = 0;
+    (*world)->islandTimeCapacity = 0;
+    (*world)->maxSpeedCapacity = 0;
+
+    (*world)->fixedTimeStep = 1.0f / WORLD_STEP_RATE;
+    (*world)->maxFixedSteps = WORLD_MAX_FIXED_STEPS;
+    (*world)->accumulator = 0.0f;
+    (*world)->alpha = 1.0f;
+
+    (*world)->adaptiveSubsteps = false;
+    (*world)->minSubsteps = WORLD_MIN_SUBSTEPS;
+    (*world)->maxSubsteps = WORLD_MAX_SUBSTEPS;
+    (*world)->lastSubsteps = 0;
+    (*world)->lastMaxDepth = 0.0f;
+
+    (*world)->continuous = false;
+    (*world)->ccdTime = NULL;
+    (*world)->ccdTimeCapacity = 0;
+
+    (*world)->deadCount = 0;
+    (*world)->bounded = false;
+    AABB_Set(&(*world)->bounds, -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX);
+    (*world)->remap = NULL;
+    (*world)->remapCapacity = 0;
+
+    (*world)->checksums = false;
+    (*world)->checksum = 0;
+
+    (*world)->narrowPhase = WorldNarrowPhase_SAT;
+
+    (*world)->pairCount = 0;
+    (*world)->contactCount = 0;
+
+    memset(&(*world)->stats, 0, sizeof(WorldStats));
 }
 void World_CreateDefault(World **world)
 {
@@ -26,123 +96,1367 @@ void World_CreateDefault(World **world)
     World_Create(world, gravity);
 }
 
-void World_AddBody(World *world, Body *body)
+void World_Reserve(World *world, int capacity)
 {
-    BodyList_Push(&world->bodies, body);
+    if (!BodyList_Reserve(&world->bodies, capacity))
+    {
+        printf("Error when reserving the bodies.\n");
+        return;
+    }
+
+    BroadPhase_Reserve(&world->broadPhase, capacity);
 }
 
+BodyHandle World_AddBody(World *world, Body *body)
+{
+    BodyHandle handle = BodyList_Push(&world->bodies, body);
 
-void World_Destroy(World **world)
+    if (handle.slot == -1)
+    {
+        return handle;
+    }
+
+    int index = world->bodies.length - 1;
+    BodyList_GetAABB(&world->bodies, index);
+    BroadPhase_Insert(&world->broadPhase, &world->bodies, index);
+
+    return handle;
+}
+
+bool World_RemoveBody(World *world, BodyHandle handle)
 {
-    if (*world != NULL && world != NULL)
+    int index = BodyList_GetIndex(&world->bodies, handle);
+
+    if (index == -1)
     {
-        if ((*world)->bodies.bodies != NULL)
+        return false;
+    }
+
+    /* whatever was resting on it has to fall */
+    if (world->sleeping)
+    {
+        BodyList *bodies = &world->bodies;
+
+        for (int i = 0; i < bodies->length; ++i)
         {
-            BodyList_Destroy(&(*world)->bodies);
+            if (!BodyList_IsAwake(bodies, i) && AABB_Overlap(bodies->bodies[i].aabb, bodies->bodies[index].aabb))
+            {
+                BodyList_Wake(bodies, i);
+            }
         }
+    }
+
+    BroadPhase_Remove(&world->broadPhase, &world->bodies, index);
+    BodyList_Remove(&world->bodies, index);
+
+    return true;
+}
+
+/*
+    Marks the body dead, it stays in the world until the next World_Step compacts the
+    bodies. Unlike World_RemoveBody the indices do not move until then.
+*/
+bool World_DestroyBody(World *world, BodyHandle handle)
+{
+    int index = BodyList_GetIndex(&world->bodies, handle);
+
+    if (index == -1 || world->bodies.bodies[index].isDead)
+    {
+        return false;
+    }
 
-        free(*world);
+    world->bodies.bodies[index].isDead = true;
+    world->deadCount++;
+
+    return true;
+}
+
+void World_SetBounds(World *world, bool enabled, Vector2 min, Vector2 max)
+{
+    world->bounded = enabled;
+    AABB_Setv(&world->bounds, min, max);
+}
+
+void World_WakeBody(World *world, BodyHandle handle)
+{
+    int index = BodyList_GetIndex(&world->bodies, handle);
+
+    if (index != -1)
+    {
+        BodyList_Wake(&world->bodies, index);
     }
 }
 
-void World_Step(World *world, Window *window, int interations, float time)
+int World_GetBodyIndex(World *world, BodyHandle handle)
 {
-    for (int j = 0; j < interations; ++j)
+    return BodyList_GetIndex(&world->bodies, handle);
+}
+
+void World_SetBroadPhase(World *world, BroadPhaseType type)
+{
+    BroadPhase_Destroy(&world->broadPhase);
+    BroadPhase_Create(&world->broadPhase, type);
+    BroadPhase_Reserve(&world->broadPhase, world->bodies.capacity);
+
+    for (int i = 0; i < world->bodies.length; ++i)
+    {
+        BodyList_GetAABB(&world->bodies, i);
+        BroadPhase_Insert(&world->broadPhase, &world->bodies, i);
+    }
+}
+
+/* count includes the stepping thread, 1 runs the narrow-phase inline */
+void World_SetThreadCount(World *world, int count)
+{
+    ThreadPool_Destroy(&world->threads);
+    ThreadPool_Create(&world->threads, count);
+}
+
+/* 
+    Resolves the contacts in color order instead of contact order. The result
+    no longer matches the serial solver but does not depend on the thread count.
+*/
+void World_SetParallelResolve(World *world, bool enabled)
+{
+    world->parallelResolve = enabled;
+}
+
+/* rate in steps per second, maxSteps bounds the steps a single World_Advance runs */
+void World_SetFixedStep(World *world, float rate, int maxSteps)
+{
+    world->fixedTimeStep = 1.0f / rate;
+    world->maxFixedSteps = (maxSteps < 1) ? 1 : maxSteps;
+}
+
+/* more iterations stack taller piles, fewer cost less */
+void World_SetVelocityIterations(World *world, int iterations)
+{
+    world->velocityIterations = (iterations < 1) ? 1 : iterations;
+}
+
+/* off by default, fast bodies then rely on the substep count not to tunnel */
+void World_SetContinuous(World *world, bool enabled)
+{
+    world->continuous = enabled;
+}
+
+void World_SetAdaptiveSubsteps(World *world, bool enabled, int minSubsteps, int maxSubsteps)
+{
+    world->adaptiveSubsteps = enabled;
+    world->minSubsteps = (minSubsteps < 1) ? 1 : minSubsteps;
+    world->maxSubsteps = (maxSubsteps < world->minSubsteps) ? world->minSubsteps : maxSubsteps;
+}
+
+const char *World_SubstepReasonName(WorldSubstepReason reason)
+{
+    switch (reason)
+    {
+        case WorldSubstep_Fixed: return "Fixed";
+        case WorldSubstep_Minimum: return "Minimum";
+        case WorldSubstep_Velocity: return "Velocity";
+        case WorldSubstep_Penetration: return "Penetration";
+        default: return "Unknown";
+    }
+}
+
+void World_SetNarrowPhase(World *world, WorldNarrowPhase narrowPhase)
+{
+    world->narrowPhase = narrowPhase;
+}
+
+const char *World_NarrowPhaseName(WorldNarrowPhase narrowPhase)
+{
+    switch (narrowPhase)
+    {
+        case WorldNarrowPhase_SAT: return "SAT";
+        case WorldNarrowPhase_GJK: return "GJK";
+        default: return "Unknown";
+    }
+}
+
+/* off by default, a resting world then costs next to nothing */
+void World_SetSleeping(World *world, bool enabled)
+{
+    world->sleeping = enabled;
+
+    if (!enabled)
     {
         for (int i = 0; i < world->bodies.length; ++i)
         {
-            Body_Step(&world->bodies.bodies[i], world, interations, time);
+            BodyList_Wake(&world->bodies, i);
         }
+    }
+}
 
-        for (int i = 0; i < world->bodies.length; ++i)
+void World_SetChecksums(World *world, bool enabled)
+{
+    world->checksums = enabled;
+    world->checksum = 0;
+}
+
+void World_SetSleepThresholds(World *world, float linearVelocity, float angularVelocity, float timeToSleep)
+{
+    world->sleepLinearVelocity = linearVelocity;
+    world->sleepAngularVelocity = angularVelocity;
+    world->timeToSleep = timeToSleep;
+}
+
+void World_Destroy(World **world)
+{
+    if (*world != NULL && world != NULL)
+    {
+        if ((*world)->bodies.bodies != NULL)
         {
-            for (int j = 0; j < world->bodies.length; ++j)
-            {
-                if ((i == j) || (world->bodies.bodies[i].isStatic && world->bodies.bodies[j].isStatic))
-                {
-                    continue;
-                }
+            BodyList_Destroy(&(*world)->bodies);
+        }
 
-                Vector2 normal;
-                float depth;
+        ShapeLibrary_Destroy(&(*world)->shapes);
+        BroadPhase_Destroy(&(*world)->broadPhase);
+        PairList_Destroy(&(*world)->pairs);
 
-                if (World_Collide(&world->bodies.bodies[i], &world->bodies.bodies[j], &normal, &depth))
-                {
-                    Vector2 resolve;
-
-                    if (world->bodies.bodies[i].isStatic)
-                    {
-                        Vector2_Mult(&resolve, normal, -depth * 0.5f);
-                        Body_Move(&world->bodies.bodies[j], resolve);
-                    }
-                    else if (world->bodies.bodies[j].isStatic)
-                    {
-                        Vector2_Mult(&resolve, normal, depth * 0.5f);
-                        Body_Move(&world->bodies.bodies[i], resolve);
-                    }
-                    else
-                    {
-                        Vector2_Mult(&resolve, normal, depth);
-                        Body_Move(&world->bodies.bodies[i], resolve);
-
-                        Vector2_Multl(&resolve, -1.0f);
-                        Body_Move(&world->bodies.bodies[j], resolve);
-                    }
-
-                    World_ResolveCollision(&world->bodies.bodies[i], &world->bodies.bodies[j], normal);
-                }
-            }
+        ThreadPool_Destroy(&(*world)->threads);
+        ContactList_Destroy(&(*world)->contacts);
+        ContactList_Destroy(&(*world)->coloredContacts);
+        ContactCache_Destroy(&(*world)->contactCache);
+        Alloc_Free((*world)->bodyColors);
+        Alloc_Free((*world)->contactColors);
+        Alloc_Free((*world)->islandParent);
+        Alloc_Free((*world)->islandTime);
+        Alloc_Free((*world)->maxSpeed);
+        Alloc_Free((*world)->ccdTime);
+        Alloc_Free((*world)->remap);
+
+        for (int i = 0; i < THREADPOOL_MAX_WORKERS; ++i)
+        {
+            ContactList_Destroy(&(*world)->threadContacts[i]);
         }
+
+        Alloc_Free(*world);
     }
 }
 
-bool World_Collide(Body *b0, Body *b1, Vector2 *normal, float *depth)
+/* tests this worker's share of the pairs, only reads the bodies */
+static void World_NarrowPhase(void *data, int worker, int workerCount)
 {
-    if (b0->shape == Box)
+    World *world = (World *)data;
+    PairList *pairs = &world->pairs;
+    ContactList *contacts = &world->threadContacts[worker];
+
+    workerCount = world->activeThreads;
+
+    if (worker >= workerCount)
+    {
+        return;
+    }
+
+    int start = (int)((long long)pairs->length * worker / workerCount);
+    int end = (int)((long long)pairs->length * (worker + 1) / workerCount);
+
+    ContactList_Clear(contacts);
+
+    BodyList *bodies = &world->bodies;
+
+    for (int p = start; p < end; ++p)
     {
-        switch (b1->shape)
+        int i0 = pairs->pairs[p].a;
+        int i1 = pairs->pairs[p].b;
+
+        /* sleeping against sleeping or static cannot change anything */
+        if ((bodies->invMass[i0] == 0.0f || bodies->awake[i0] == 0.0f) &&
+            (bodies->invMass[i1] == 0.0f || bodies->awake[i1] == 0.0f))
         {
-            case Box:
-                return (IntersectPolygon(b1->transformedVertices, b1->vertLength, 
-                                        b0->transformedVertices, b0->vertLength, 
-                                        normal, depth));
-            break;
+            continue;
+        }
 
-            case Circle:
-                return (IntersectPolygonCircle(b0->transformedVertices, b0->vertLength,
-                                            b1->position, b1->radius, 
-                                            normal, depth));
-            break;
+        Contact contact;
+
+        if (World_Collide(bodies, world->narrowPhase, i0, i1, &contact))
+        {
+            int s0 = bodies->slots[i0];
+            int s1 = bodies->slots[i1];
+
+            contact.pair = ((Uint64)s0 << 32) | (Uint64)s1;
+            contact.generations = ((Uint64)bodies->slotGeneration[s0] << 32) | (Uint64)bodies->slotGeneration[s1];
+            ContactList_Push(contacts, &contact);
         }
     }
+}
+
+static void World_ApplyImpulse(BodyList *bodies, int a, int b, Vector2 normal, float impulse)
+{
+    float invMassA = bodies->invMass[a];
+    float invMassB = bodies->invMass[b];
+
+    /* static bodies are shared by every color batch, never write them */
+    if (invMassA != 0.0f)
+    {
+        bodies->velocityX[a] = bodies->velocityX[a] + normal[0] * impulse * invMassA;
+        bodies->velocityY[a] = bodies->velocityY[a] + normal[1] * impulse * invMassA;
+    }
+
+    if (invMassB != 0.0f)
+    {
+        bodies->velocityX[b] = bodies->velocityX[b] - normal[0] * impulse * invMassB;
+        bodies->velocityY[b] = bodies->velocityY[b] - normal[1] * impulse * invMassB;
+    }
+}
+
+static float World_NormalVelocity(BodyList *bodies, Contact *contact)
+{
+    int a = contact->a;
+    int b = contact->b;
+
+    return (bodies->velocityX[a] - bodies->velocityX[b]) * contact->normal[0] + 
+            (bodies->velocityY[a] - bodies->velocityY[b]) * contact->normal[1];
+}
+
+/* effective mass, restitution target and the impulse the last solve ended with */
+static void World_PrepareContact(World *world, Contact *contact)
+{
+    BodyList *bodies = &world->bodies;
+    int a = contact->a;
+    int b = contact->b;
+
+    float e = fminf(bodies->resistituion[a], bodies->resistituion[b]);
+    float normalVelocity = World_NormalVelocity(bodies, contact);
+    float massNormal = 1.0f / (bodies->invMass[a] + bodies->invMass[b]);
+
+    for (int i = 0; i < contact->pointCount; ++i)
+    {
+        ContactPoint *point = &contact->points[i];
+
+        point->massNormal = massNormal;
+        point->velocityBias = (normalVelocity < -WORLD_RESTITUTION_THRESHOLD) ? -e * normalVelocity : 0.0f;
+        point->normalImpulse = ContactCache_Find(&world->contactCache, contact->pair, contact->generations, 
+                                                point->feature);
+    }
+}
+
+static void World_WarmStartContact(World *world, Contact *contact)
+{
+    for (int i = 0; i < contact->pointCount; ++i)
+    {
+        World_ApplyImpulse(&world->bodies, contact->a, contact->b, contact->normal, contact->points[i].normalImpulse);
+    }
+}
+
+/* one sequential impulse pass, the accumulated impulse is clamped, not each increment */
+static void World_SolveContact(World *world, Contact *contact)
+{
+    BodyList *bodies = &world->bodies;
+
+    for (int i = 0; i < contact->pointCount; ++i)
+    {
+        ContactPoint *point = &contact->points[i];
+
+        float normalVelocity = World_NormalVelocity(bodies, contact);
+        float lambda = point->massNormal * (point->velocityBias - normalVelocity);
+
+        float impulse = fmaxf(point->normalImpulse + lambda, 0.0f);
+        lambda = impulse - point->normalImpulse;
+        point->normalImpulse = impulse;
+
+        World_ApplyImpulse(bodies, contact->a, contact->b, contact->normal, lambda);
+    }
+}
+
+/* pushes the pair apart along the contact normal, only the depth past the slop */
+static void World_CorrectContact(World *world, Contact *contact)
+{
+    BodyList *bodies = &world->bodies;
+    int i0 = contact->a;
+    int i1 = contact->b;
+    float depth = (contact->depth - WORLD_LINEAR_SLOP) * WORLD_BAUMGARTE;
+
+    if (depth <= 0.0f)
+    {
+        return;
+    }
+
+    Vector2 resolve;
+
+    if (bodies->invMass[i0] == 0.0f)
+    {
+        Vector2_Mult(&resolve, contact->normal, -depth);
+        BodyList_Translate(bodies, i1, resolve);
+    }
+    else if (bodies->invMass[i1] == 0.0f)
+    {
+        Vector2_Mult(&resolve, contact->normal, depth);
+        BodyList_Translate(bodies, i0, resolve);
+    }
     else
     {
-        if (b0->shape == Circle)
+        Vector2_Mult(&resolve, contact->normal, depth * 0.5f);
+        BodyList_Translate(bodies, i0, resolve);
+
+        Vector2_Multl(&resolve, -1.0f);
+        BodyList_Translate(bodies, i1, resolve);
+    }
+}
+
+static bool World_Grow(void **array, int *capacity, int length, size_t size)
+{
+    if (length <= *capacity)
+    {
+        return true;
+    }
+
+    int grown = (*capacity > 0) ? *capacity : 64;
+
+    while (grown < length)
+    {
+        grown *= 2;
+    }
+
+    void *temp = Alloc_Realloc(*array, grown * size);
+
+    if (temp == NULL)
+    {
+        printf("Error when growing the contact coloring.\n");
+        return false;
+    }
+
+    *array = temp;
+    *capacity = grown;
+
+    return true;
+}
+
+/* greedy coloring in contact order, the same contacts always get the same colors */
+static bool World_ColorContacts(World *world)
+{
+    BodyList *bodies = &world->bodies;
+    ContactList *contacts = &world->contacts;
+
+    if (!World_Grow((void **)&world->bodyColors, &world->bodyColorCapacity, bodies->length, sizeof(Uint64)) ||
+        !World_Grow((void **)&world->contactColors, &world->contactColorCapacity, contacts->length, sizeof(int)) ||
+        !ContactList_Resize(&world->coloredContacts, contacts->length))
+    {
+        return false;
+    }
+
+    memset(world->bodyColors, 0, bodies->length * sizeof(Uint64));
+    memset(world->colorStart, 0, sizeof(world->colorStart));
+
+    int colorCount = 0;
+
+    for (int c = 0; c < contacts->length; ++c)
+    {
+        int a = contacts->contacts[c].a;
+        int b = contacts->contacts[c].b;
+
+        bool dynamicA = bodies->invMass[a] != 0.0f;
+        bool dynamicB = bodies->invMass[b] != 0.0f;
+
+        Uint64 used = ((dynamicA) ? world->bodyColors[a] : 0) | ((dynamicB) ? world->bodyColors[b] : 0);
+        int color = WORLD_MAX_COLORS;
+
+        if (~used != 0)
         {
-            return (IntersectCircle(b1->position, b1->radius, b0->position, b0->radius, normal, depth));
+            color = __builtin_ctzll(~used);
+
+            if (dynamicA) world->bodyColors[a] |= 1ull << color;
+            if (dynamicB) world->bodyColors[b] |= 1ull << color;
+
+            if (color + 1 > colorCount) colorCount = color + 1;
         }
+
+        world->contactColors[c] = color;
+        world->colorStart[color + 1]++;
+    }
+
+    for (int k = 0; k <= WORLD_MAX_COLORS; ++k)
+    {
+        world->colorStart[k + 1] += world->colorStart[k];
     }
+
+    /* stable scatter, colorStart[k] ends up at the end of color k and is shifted back */
+    for (int c = 0; c < contacts->length; ++c)
+    {
+        int color = world->contactColors[c];
+        world->coloredContacts.contacts[world->colorStart[color]++] = contacts->contacts[c];
+    }
+
+    for (int k = WORLD_MAX_COLORS; k > 0; --k)
+    {
+        world->colorStart[k] = world->colorStart[k - 1];
+    }
+
+    world->colorStart[0] = 0;
+
+    if (colorCount > world->stats.colorCount)
+    {
+        world->stats.colorCount = colorCount;
+    }
+
+    return true;
 }
 
-void World_ResolveCollision(Body *b0, Body *b1, Vector2 normal)
+/* runs this worker's share of the current color, no two contacts share a dynamic body */
+static void World_ContactBatch(void *data, int worker, int workerCount)
 {
-    Vector2 relativeVelocity;
-    Vector2_Sub(&relativeVelocity, b1->linearVelocity, b0->linearVelocity);
+    World *world = (World *)data;
+    workerCount = world->activeThreads;
+
+    if (worker >= workerCount)
+    {
+        return;
+    }
+
+    int length = world->batchEnd - world->batchStart;
+    int start = world->batchStart + (int)((long long)length * worker / workerCount);
+    int end = world->batchStart + (int)((long long)length * (worker + 1) / workerCount);
 
-    if (Vector2_Dot(relativeVelocity, normal) < 0.0f)
+    for (int c = start; c < end; ++c)
     {
+        world->batchFunction(world, &world->coloredContacts.contacts[c]);
+    }
+}
+
+/* in contact order, or color after color across the workers when the contacts were colored */
+static void World_ForEachContact(World *world, WorldContactFunction function)
+{
+    if (!world->colored)
+    {
+        for (int c = 0; c < world->contacts.length; ++c)
+        {
+            function(world, &world->contacts.contacts[c]);
+        }
+
         return;
     }
 
-    float e = SDL_min(b0->resistituion, b1->resistituion);
-    float j = ((-(1 + e) * Vector2_Dot(relativeVelocity, normal)) / (b0->invMass + b1->invMass));
+    world->batchFunction = function;
 
-    Vector2 impulse;
-    Vector2_Mult(&impulse, normal, j);
-    Vector2_Multl(&impulse, b0->invMass);
-    Vector2_Subl(&b0->linearVelocity, impulse);
+    for (int k = 0; k <= WORLD_MAX_COLORS; ++k)
+    {
+        world->batchStart = world->colorStart[k];
+        world->batchEnd = world->colorStart[k + 1];
+
+        int length = world->batchEnd - world->batchStart;
+
+        /* the overflow group may share bodies */
+        world->activeThreads = (k < WORLD_MAX_COLORS) ? length / WORLD_MIN_THREAD_CONTACTS : 1;
+
+        if (world->activeThreads > world->threads.count) world->activeThreads = world->threads.count;
+        if (world->activeThreads < 1) world->activeThreads = 1;
 
-    Vector2_Mult(&impulse, normal, j);
-    Vector2_Multl(&impulse, b1->invMass);
-    Vector2_Addl(&b1->linearVelocity, impulse);
-}
\ No newline at end of file
+        if (world->activeThreads == 1)
+        {
+            World_ContactBatch(world, 0, 1);
+        }
+        else
+        {
+            ThreadPool_Run(&world->threads, World_ContactBatch, world);
+        }
+    }
+}
+
+/* the accumulated impulses of this substep warm start the next one */
+static void World_StoreImpulses(World *world)
+{
+    ContactList *contacts = (world->colored) ? &world->coloredContacts : &world->contacts;
+
+    for (int c = 0; c < contacts->length; ++c)
+    {
+        Contact *contact = &contacts->contacts[c];
+
+        for (int i = 0; i < contact->pointCount; ++i)
+        {
+            ContactCache_Store(&world->contactCache, contact->pair, contact->generations, contact->points[i].feature, 
+                            contact->points[i].normalImpulse);
+        }
+    }
+}
+
+static void World_Solve(World *world)
+{
+    int pointCount = 0;
+
+    for (int c = 0; c < world->contacts.length; ++c)
+    {
+        pointCount += world->contacts.contacts[c].pointCount;
+        world->stats.maxDepth = fmaxf(world->stats.maxDepth, world->contacts.contacts[c].depth);
+    }
+
+    ContactCache_Begin(&world->contactCache, pointCount);
+    world->colored = world->parallelResolve && World_ColorContacts(world);
+
+    World_ForEachContact(world, World_PrepareContact);
+    World_ForEachContact(world, World_WarmStartContact);
+
+    for (int i = 0; i < world->velocityIterations; ++i)
+    {
+        World_ForEachContact(world, World_SolveContact);
+    }
+
+    World_ForEachContact(world, World_CorrectContact);
+    World_StoreImpulses(world);
+}
+
+static int World_FindIsland(int *parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+
+    return i;
+}
+
+/* islands start as single bodies, speeds at rest */
+static bool World_BeginSleep(World *world)
+{
+    BodyList *bodies = &world->bodies;
+
+    if (!World_Grow((void **)&world->islandParent, &world->islandCapacity, bodies->length, sizeof(int)) ||
+        !World_Grow((void **)&world->islandTime, &world->islandTimeCapacity, bodies->length, sizeof(float)) ||
+        !World_Grow((void **)&world->maxSpeed, &world->maxSpeedCapacity, bodies->length, sizeof(float)))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        world->islandParent[i] = i;
+    }
+
+    memset(world->maxSpeed, 0, bodies->length * sizeof(float));
+
+    return true;
+}
+
+/* keeps the largest squared speed each body ended a substep with */
+static void World_TrackSpeed(World *world)
+{
+    BodyList *bodies = &world->bodies;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        float speedSquared = bodies->velocityX[i] * bodies->velocityX[i] + bodies->velocityY[i] * bodies->velocityY[i];
+        world->maxSpeed[i] = fmaxf(world->maxSpeed[i], speedSquared);
+    }
+}
+
+/*
+    Wakes the sleeping side of every contact before it gets resolved and joins the
+    dynamic pairs into islands. Resting contacts flicker between substeps, so the
+    islands gather every substep of the step, not only the last one. Static bodies
+    do not join islands, the ground would merge everything.
+*/
+static void World_LinkContacts(World *world)
+{
+    BodyList *bodies = &world->bodies;
+    int *parent = world->islandParent;
+
+    for (int c = 0; c < world->contacts.length; ++c)
+    {
+        int a = world->contacts.contacts[c].a;
+        int b = world->contacts.contacts[c].b;
+
+        if (!BodyList_IsAwake(bodies, a)) BodyList_Wake(bodies, a);
+        if (!BodyList_IsAwake(bodies, b)) BodyList_Wake(bodies, b);
+
+        if (bodies->invMass[a] != 0.0f && bodies->invMass[b] != 0.0f)
+        {
+            parent[World_FindIsland(parent, a)] = World_FindIsland(parent, b);
+        }
+    }
+}
+
+static void World_UpdateSleep(World *world, float time)
+{
+    BodyList *bodies = &world->bodies;
+
+    int *parent = world->islandParent;
+    float *islandTime = world->islandTime;
+    float linearVelocity = world->sleepLinearVelocity * world->sleepLinearVelocity;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        islandTime[i] = FLT_MAX;
+
+        if (bodies->invMass[i] == 0.0f || bodies->awake[i] == 0.0f)
+        {
+            continue;
+        }
+
+        if (world->maxSpeed[i] > linearVelocity || fabsf(bodies->bodies[i].rotationVelocity) > world->sleepAngularVelocity)
+        {
+            bodies->sleepTime[i] = 0.0f;
+        }
+        else
+        {
+            bodies->sleepTime[i] += time;
+        }
+    }
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        if (bodies->invMass[i] != 0.0f && bodies->awake[i] != 0.0f)
+        {
+            int root = World_FindIsland(parent, i);
+            islandTime[root] = fminf(islandTime[root], bodies->sleepTime[i]);
+        }
+    }
+
+    int awakeCount = 0;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        if (bodies->invMass[i] == 0.0f || bodies->awake[i] == 0.0f)
+        {
+            continue;
+        }
+
+        if (islandTime[World_FindIsland(parent, i)] >= world->timeToSleep)
+        {
+            bodies->awake[i] = 0.0f;
+            bodies->velocityX[i] = 0.0f;
+            bodies->velocityY[i] = 0.0f;
+        }
+        else
+        {
+            awakeCount++;
+        }
+    }
+
+    world->stats.awakeCount = awakeCount;
+}
+
+static int World_CountAwake(World *world)
+{
+    BodyList *bodies = &world->bodies;
+    int count = 0;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        count += (bodies->invMass[i] != 0.0f && bodies->awake[i] != 0.0f);
+    }
+
+    return count;
+}
+
+/* convex view of body i for SeparationConvex, a circle is its center without normals */
+static void World_GetConvex(BodyList *bodies, int i, Vector2 *center, Vector2 **vertices, Vector2 **normals, 
+                            int *length, float *radius)
+{
+    Body *body = &bodies->bodies[i];
+
+    if (body->shape == Circle)
+    {
+        Vector2_Set(center, bodies->positionX[i], bodies->positionY[i]);
+
+        *vertices = center;
+        *normals = NULL;
+        *length = 1;
+        *radius = body->radius;
+    }
+    else
+    {
+        *vertices = BodyList_GetVertices(bodies, i);
+        *normals = BodyList_GetNormals(bodies, i);
+        *length = body->vertLength;
+        *radius = 0.0f;
+    }
+}
+
+/*
+    Conservative advancement of body fast along sweep (its motion over the substep,
+    ending at its current position) against body other held still. Each round moves
+    fast until the best separating axis closes, a little past it by WORLD_CCD_SLOP
+    so the narrow-phase sees the contact. Returns the fraction of the substep, 1
+    for no impact; bodies already overlapping at the start are left to the solver.
+*/
+static float World_TimeOfImpact(BodyList *bodies, int fast, int other, Vector2 sweep)
+{
+    Vector2 centerA, centerB;
+    Vector2 *verticesA, *verticesB, *normalsA, *normalsB;
+    int lengthA, lengthB;
+    float radiusA, radiusB;
+
+    World_GetConvex(bodies, other, &centerA, &verticesA, &normalsA, &lengthA, &radiusA);
+    World_GetConvex(bodies, fast, &centerB, &verticesB, &normalsB, &lengthB, &radiusB);
+
+    float t = 0.0f;
+
+    for (int i = 0; i < WORLD_CCD_ITERATIONS; ++i)
+    {
+        Vector2 offset, axis;
+        Vector2_Mult(&offset, sweep, t - 1.0f);
+
+        float separation = SeparationConvex(verticesA, normalsA, lengthA, radiusA, 
+                                            verticesB, normalsB, lengthB, radiusB, 
+                                            offset, &axis);
+
+        if (separation <= 0.0f)
+        {
+            return (i == 0) ? 1.0f : t;
+        }
+
+        float closing = -Vector2_Dot(sweep, axis);
+
+        if (closing <= 0.0f)
+        {
+            return 1.0f;
+        }
+
+        t += (separation + WORLD_CCD_SLOP) / closing;
+
+        if (t >= 1.0f)
+        {
+            return 1.0f;
+        }
+    }
+
+    return t;
+}
+
+/* flags the bodies moving too far this substep and sweeps their AABB back over the motion */
+static bool World_SweepBodies(World *world, float time)
+{
+    BodyList *bodies = &world->bodies;
+
+    if (!World_Grow((void **)&world->ccdTime, &world->ccdTimeCapacity, bodies->length, sizeof(float)))
+    {
+        return false;
+    }
+
+    bool swept = false;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        world->ccdTime[i] = -1.0f;
+
+        if (bodies->invMass[i] == 0.0f || bodies->awake[i] == 0.0f)
+        {
+            continue;
+        }
+
+        float dx = bodies->velocityX[i] * time;
+        float dy = bodies->velocityY[i] * time;
+        float reach = WORLD_CCD_FRACTION * bodies->bodies[i].boundingRadius;
+
+        if (dx * dx + dy * dy <= reach * reach)
+        {
+            continue;
+        }
+
+        AABB *aabb = &bodies->bodies[i].aabb;
+
+        (*aabb)[0][0] = fminf((*aabb)[0][0], (*aabb)[0][0] - dx);
+        (*aabb)[0][1] = fminf((*aabb)[0][1], (*aabb)[0][1] - dy);
+        (*aabb)[1][0] = fmaxf((*aabb)[1][0], (*aabb)[1][0] - dx);
+        (*aabb)[1][1] = fmaxf((*aabb)[1][1], (*aabb)[1][1] - dy);
+
+        world->ccdTime[i] = 1.0f;
+        swept = true;
+    }
+
+    return swept;
+}
+
+/* pulls every swept body back to its earliest impact with a slow body */
+static void World_ContinuousCollision(World *world, float time)
+{
+    BodyList *bodies = &world->bodies;
+    PairList *pairs = &world->pairs;
+    float *ccdTime = world->ccdTime;
+
+    for (int p = 0; p < pairs->length; ++p)
+    {
+        int a = pairs->pairs[p].a;
+        int b = pairs->pairs[p].b;
+
+        bool fastA = ccdTime[a] >= 0.0f;
+        bool fastB = ccdTime[b] >= 0.0f;
+
+        if (fastA == fastB)
+        {
+            continue;
+        }
+
+        int fast = (fastA) ? a : b;
+        int other = (fastA) ? b : a;
+
+        Vector2 sweep = {bodies->velocityX[fast] * time, bodies->velocityY[fast] * time};
+        ccdTime[fast] = fminf(ccdTime[fast], World_TimeOfImpact(bodies, fast, other, sweep));
+    }
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        if (ccdTime[i] < 0.0f)
+        {
+            continue;
+        }
+
+        if (ccdTime[i] < 1.0f)
+        {
+            Vector2 back = {bodies->velocityX[i] * time * (ccdTime[i] - 1.0f), 
+                            bodies->velocityY[i] * time * (ccdTime[i] - 1.0f)};
+
+            BodyList_Translate(bodies, i, back);
+            world->stats.ccdCount++;
+        }
+
+        BodyList_GetAABB(bodies, i);
+    }
+}
+
+/* marks dead the dynamic bodies whose AABB left the world bounds */
+static void World_CullBodies(World *world)
+{
+    BodyList *bodies = &world->bodies;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *body = &bodies->bodies[i];
+
+        if (!body->isStatic && !body->isDead && !AABB_Overlap(body->aabb, world->bounds))
+        {
+            body->isDead = true;
+            world->deadCount++;
+        }
+    }
+}
+
+/* drops every dead body at once, the broad-phase follows through the remap */
+static void World_RemoveDead(World *world)
+{
+    BodyList *bodies = &world->bodies;
+    int length = bodies->length;
+
+    if (!World_Grow((void **)&world->remap, &world->remapCapacity, length, sizeof(int)))
+    {
+        return;
+    }
+
+    /* whatever was resting on them has to fall, remap holds the dead indices until the compaction */
+    if (world->sleeping)
+    {
+        int *dead = world->remap;
+        int deadLength = 0;
+
+        for (int i = 0; i < length; ++i)
+        {
+            if (bodies->bodies[i].isDead)
+            {
+                dead[deadLength++] = i;
+            }
+        }
+
+        for (int i = 0; i < length; ++i)
+        {
+            if (BodyList_IsAwake(bodies, i) || bodies->bodies[i].isDead)
+            {
+                continue;
+            }
+
+            for (int j = 0; j < deadLength; ++j)
+            {
+                if (AABB_Overlap(bodies->bodies[i].aabb, bodies->bodies[dead[j]].aabb))
+                {
+                    BodyList_Wake(bodies, i);
+                    break;
+                }
+            }
+        }
+    }
+
+    world->stats.removedCount += BodyList_Compact(bodies, world->remap);
+    BroadPhase_Compact(&world->broadPhase, world->remap, length);
+
+    /* the last pairs and contacts point at the old indices */
+    PairList_Clear(&world->pairs);
+    ContactList_Clear(&world->contacts);
+
+    world->deadCount = 0;
+}
+
+static Uint64 World_Mix(Uint64 hash, float value)
+{
+    Uint32 bits;
+    memcpy(&bits, &value, sizeof(Uint32));
+
+    return (hash ^ bits) * 0x100000001b3ull;
+}
+
+/* FNV-1a over 32 bit words, cheap next to a step */
+static Uint64 World_HashBodies(World *world, Uint64 hash)
+{
+    BodyList *bodies = &world->bodies;
+
+    hash = (hash ^ (Uint64)bodies->length) * 0x100000001b3ull;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        hash = World_Mix(hash, bodies->positionX[i]);
+        hash = World_Mix(hash, bodies->positionY[i]);
+        hash = World_Mix(hash, bodies->velocityX[i]);
+        hash = World_Mix(hash, bodies->velocityY[i]);
+        hash = World_Mix(hash, bodies->bodies[i].rotation);
+        hash = World_Mix(hash, bodies->bodies[i].rotationVelocity);
+    }
+
+    return hash;
+}
+
+/* bodies are sized by their bounding radius, the smallest awake dynamic one sets the scale */
+static int World_ChooseSubsteps(World *world, float time, WorldSubstepReason *reason)
+{
+    BodyList *bodies = &world->bodies;
+
+    float maxSpeedSquared = 0.0f;
+    float minRadius = FLT_MAX;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        if (bodies->invMass[i] == 0.0f || bodies->awake[i] == 0.0f)
+        {
+            continue;
+        }
+
+        float speedSquared = bodies->velocityX[i] * bodies->velocityX[i] + bodies->velocityY[i] * bodies->velocityY[i];
+
+        maxSpeedSquared = fmaxf(maxSpeedSquared, speedSquared);
+        minRadius = fminf(minRadius, bodies->bodies[i].boundingRadius);
+    }
+
+    int count = world->minSubsteps;
+    *reason = WorldSubstep_Minimum;
+
+    if (minRadius == FLT_MAX || minRadius <= 0.0f)
+    {
+        return count;
+    }
+
+    float travel = sqrtf(maxSpeedSquared) * time / (WORLD_SUBSTEP_TRAVEL * minRadius);
+    /* the solver leaves WORLD_LINEAR_SLOP of overlap on resting contacts, it is not tunneling */
+    float depth = fmaxf(world->lastMaxDepth - WORLD_LINEAR_SLOP, 0.0f);
+    float penetration = world->lastSubsteps * depth / (WORLD_SUBSTEP_DEPTH * minRadius);
+
+    /* compared before ceilf, they are unbounded on a fast enough body */
+    if (travel > count && !world->continuous)
+    {
+        count = (travel < world->maxSubsteps) ? (int)ceilf(travel) : world->maxSubsteps;
+        *reason = WorldSubstep_Velocity;
+    }
+
+    if (penetration > count)
+    {
+        count = (penetration < world->maxSubsteps) ? (int)ceilf(penetration) : world->maxSubsteps;
+        *reason = WorldSubstep_Penetration;
+    }
+
+    return count;
+}
+
+void World_Step(World *world, int interations, float time)
+{
+    BodyList *bodies = &world->bodies;
+    WorldStats *stats = &world->stats;
+
+    world->pairCount = 0;
+    world->contactCount = 0;
+    memset(stats, 0, sizeof(WorldStats));
+
+    Uint64 stepStart = Timer_Now();
+
+    if (world->deadCount > 0)
+    {
+        World_RemoveDead(world);
+    }
+
+    stats->awakeCount = World_CountAwake(world);
+    stats->substepReason = WorldSubstep_Fixed;
+
+    if (world->adaptiveSubsteps)
+    {
+        interations = World_ChooseSubsteps(world, time, &stats->substepReason);
+    }
+
+    /* nothing awake, nothing can collide or move */
+    if (world->sleeping && (stats->awakeCount == 0 || !World_BeginSleep(world)))
+    {
+        interations = 0;
+    }
+
+    for (int j = 0; j < interations; ++j)
+    {
+        Uint64 start = Timer_Now();
+
+        Body_Step(bodies, world, interations, time);
+
+        Uint64 integrated = Timer_Now();
+
+        for (int i = 0; i < bodies->length; ++i)
+        {
+            if (BodyList_IsAwake(bodies, i))
+            {
+                BodyList_GetAABB(bodies, i);
+            }
+        }
+
+        bool swept = world->continuous && World_SweepBodies(world, time / interations);
+
+        PairList_Clear(&world->pairs);
+        BroadPhase_Update(&world->broadPhase, bodies);
+        BroadPhase_FindPairs(&world->broadPhase, bodies, &world->pairs);
+
+        Uint64 broadPhase = Timer_Now();
+
+        if (swept)
+        {
+            World_ContinuousCollision(world, time / interations);
+        }
+
+        world->pairCount += world->pairs.length;
+
+        world->activeThreads = world->pairs.length / WORLD_MIN_THREAD_PAIRS;
+
+        if (world->activeThreads > world->threads.count) world->activeThreads = world->threads.count;
+        if (world->activeThreads < 1) world->activeThreads = 1;
+
+        if (world->activeThreads == 1)
+        {
+            World_NarrowPhase(world, 0, 1);
+        }
+        else
+        {
+            ThreadPool_Run(&world->threads, World_NarrowPhase, world);
+        }
+
+        ContactList_Clear(&world->contacts);
+
+        for (int w = 0; w < world->activeThreads; ++w)
+        {
+            ContactList_Append(&world->contacts, &world->threadContacts[w]);
+        }
+
+        world->contactCount += world->contacts.length;
+
+        Uint64 narrowPhase = Timer_Now();
+
+        if (world->sleeping)
+        {
+            World_LinkContacts(world);
+        }
+
+        World_Solve(world);
+
+        if (world->sleeping)
+        {
+            World_TrackSpeed(world);
+        }
+
+        Uint64 end = Timer_Now();
+
+        stats->integrateTime += integrated - start;
+        stats->broadPhaseTime += broadPhase - integrated;
+        stats->narrowPhaseTime += narrowPhase - broadPhase;
+        stats->resolveTime += end - narrowPhase;
+    }
+
+    if (world->sleeping && interations > 0)
+    {
+        World_UpdateSleep(world, time);
+    }
+
+    if (world->bounded)
+    {
+        World_CullBodies(world);
+    }
+
+    if (world->deadCount > 0)
+    {
+        World_RemoveDead(world);
+    }
+
+    if (world->checksums)
+    {
+        world->checksum = World_HashBodies(world, world->checksum);
+    }
+
+    stats->substepCount = interations;
+    world->lastSubsteps = interations;
+    world->lastMaxDepth = stats->maxDepth;
+
+    stats->stepTime = Timer_Now() - stepStart;
+    stats->pairCount = world->pairCount;
+    stats->contactCount = world->contactCount;
+}
+
+/*
+    Steps the world by whole fixed steps covering elapsedTime plus what was left
+    from the previous frames, returns the steps taken. When a frame would need more
+    than maxFixedSteps the remaining time is dropped instead of carried over, a slow
+    frame then slows the simulation down rather than making every frame after it slower.
+*/
+int World_Advance(World *world, int interations, float elapsedTime)
+{
+    world->accumulator += elapsedTime;
+
+    int steps = 0;
+    float dropped = 0.0f;
+
+    while (world->accumulator >= world->fixedTimeStep)
+    {
+        if (steps == world->maxFixedSteps)
+        {
+            dropped = world->accumulator - fmodf(world->accumulator, world->fixedTimeStep);
+            world->accumulator -= dropped;
+            break;
+        }
+
+        BodyList_SavePositions(&world->bodies);
+        World_Step(world, interations, world->fixedTimeStep);
+
+        world->accumulator -= world->fixedTimeStep;
+        steps++;
+    }
+
+    world->alpha = world->accumulator / world->fixedTimeStep;
+    world->stats.fixedSteps = steps;
+    world->stats.droppedTime = dropped;
+
+    return steps;
+}
+
+/* position of body index for rendering, between its last two fixed steps */
+void World_GetInterpolated(World *world, int index, Vector2 *position)
+{
+    BodyList_GetInterpolated(&world->bodies, index, world->alpha, position);
+}
+
+void World_GetStats(World *world, WorldStats *stats)
+{
+    (*stats) = world->stats;
+}
+
+/*
+    Fills contact with the manifold of bodies i0 and i1, normal pointing from i1 to i0.
+    Circles touch in one point on the surface of i1, polygons get their clipped points.
+    Boxes and polygons are the same to it, narrowPhase picks SAT or GJK for them.
+*/
+bool World_Collide(BodyList *bodies, WorldNarrowPhase narrowPhase, int i0, int i1, Contact *contact)
+{
+    Body *b0 = &bodies->bodies[i0];
+    Body *b1 = &bodies->bodies[i1];
+
+    Vector2 p0 = {bodies->positionX[i0], bodies->positionY[i0]};
+    Vector2 p1 = {bodies->positionX[i1], bodies->positionY[i1]};
+
+    Vector2 *v0 = BodyList_GetVertices(bodies, i0);
+    Vector2 *v1 = BodyList_GetVertices(bodies, i1);
+
+    Vector2 *n0 = BodyList_GetNormals(bodies, i0);
+    Vector2 *n1 = BodyList_GetNormals(bodies, i1);
+
+    Vector2 c0, c1;
+    Vector2_Setv(&c0, (b0->shape == Circle) ? p0 : bodies->centroids[i0]);
+    Vector2_Setv(&c1, (b1->shape == Circle) ? p1 : bodies->centroids[i1]);
+
+    /* bounding circles first, most broad-phase pairs never get to SAT or GJK */
+    Vector2 offset;
+    Vector2_Sub(&offset, c1, c0);
+    float reach = b0->boundingRadius + b1->boundingRadius;
+
+    if (Vector2_LengthSquared(offset) > reach * reach)
+    {
+        return false;
+    }
+
+    Vector2 *normal = &contact->normal;
+    float *depth = &contact->depth;
+    ContactPoint *point = &contact->points[0];
+
+    contact->a = i0;
+    contact->b = i1;
+    contact->pointCount = 1;
+    point->feature = 0;
+
+    bool gjk = (narrowPhase == WorldNarrowPhase_GJK);
+
+    if (b0->shape != Circle && b1->shape != Circle)
+    {
+        bool hit = gjk ? IntersectConvexGJK(v1, b1->vertLength, 0.0f, c1, 
+                                            v0, b0->vertLength, 0.0f, c0, 
+                                            normal, depth)
+                        : IntersectPolygon(v1, n1, b1->vertLength, c1, 
+                                            v0, n0, b0->vertLength, c0, 
+                                            normal, depth);
+
+        if (!hit)
+        {
+            return false;
+        }
+
+        contact->pointCount = FindContactPointsPolygon(v1, n1, b1->vertLength, 
+                                                    v0, n0, b0->vertLength, 
+                                                    *normal, contact->points);
+
+        /* clipping lost both points on a grazing contact, keep one between the centers */
+        if (contact->pointCount == 0)
+        {
+            contact->pointCount = 1;
+            Vector2_Add(&point->position, c0, c1);
+            Vector2_Multl(&point->position, 0.5f);
+            point->depth = *depth;
+            point->feature = 0xffffffffu;
+        }
+
+        return true;
+    }
+    else if (b0->shape != Circle && b1->shape == Circle)
+    {
+        bool hit = gjk ? IntersectConvexGJK(&p1, 1, b1->radius, p1, v0, b0->vertLength, 0.0f, c0, normal, depth)
+                        : IntersectPolygonCircle(v0, n0, b0->vertLength, c0, &p1, b1->radius, normal, depth);
+
+        if (!hit)
+        {
+            return false;
+        }
+
+        Vector2_Set(&point->position, p1[0] + (*normal)[0] * b1->radius, p1[1] + (*normal)[1] * b1->radius);
+    }
+    else if (b0->shape == Circle && b1->shape != Circle)
+    {
+        if (gjk)
+        {
+            if (!IntersectConvexGJK(v1, b1->vertLength, 0.0f, c1, &p0, 1, b0->radius, p0, normal, depth))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            if (!IntersectPolygonCircle(v1, n1, b1->vertLength, c1, &p0, b0->radius, normal, depth))
+            {
+                return false;
+            }
+
+            Vector2_Multl(normal, -1.0f);
+        }
+
+        Vector2_Set(&point->position, p0[0] - (*normal)[0] * b0->radius, p0[1] - (*normal)[1] * b0->radius);
+    }
+    else if (b0->shape == Circle && b1->shape == Circle)
+    {
+        if (!IntersectCircle(&p1, b1->radius, &p0, b0->radius, normal, depth))
+        {
+            return false;
+        }
+
+        Vector2_Set(&point->position, p1[0] + (*normal)[0] * b1->radius, p1[1] + (*normal)[1] * b1->radius);
+    }
+    else
+    {
+        return false;
+    }
+
+    point->depth = *depth;
+
+    return true;
+}
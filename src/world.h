@@ -3,25 +3,276 @@
 
 #include "types.h"
 #include "body.h"
+#include "broadphase.h"
+#include "contact.h"
+#include "threadpool.h"
 #include <stdbool.h>
 
-typedef struct Window           Window;
 typedef struct World            World;
+typedef struct WorldStats       WorldStats;
+typedef enum   WorldSubstepReason WorldSubstepReason;
+typedef enum   WorldNarrowPhase WorldNarrowPhase;
+
+typedef void (*WorldContactFunction)(World *world, Contact *contact);
+
+/* below this many pairs per worker the wake-up costs more than the tests */
+#define WORLD_MIN_THREAD_PAIRS 256
+#define WORLD_MIN_THREAD_CONTACTS 128
+
+/* one bit per color in the body masks, contacts left over are solved serially */
+#define WORLD_MAX_COLORS 64
+
+#define WORLD_SLEEP_LINEAR_VELOCITY     8.0f
+#define WORLD_SLEEP_ANGULAR_VELOCITY    0.05f
+#define WORLD_TIME_TO_SLEEP             0.5f
+
+/* fixed stepping, past WORLD_MAX_FIXED_STEPS a frame drops the time it is behind */
+#define WORLD_STEP_RATE                 60.0f
+#define WORLD_MAX_FIXED_STEPS           4
+
+/*
+    Adaptive substeps: enough that no body moves more than WORLD_SUBSTEP_TRAVEL of the
+    smallest bounding radius per substep, and that the deepest contact of the last step
+    would have stayed under WORLD_SUBSTEP_DEPTH of it.
+*/
+#define WORLD_SUBSTEP_TRAVEL            0.5f
+#define WORLD_SUBSTEP_DEPTH             0.1f
+#define WORLD_MIN_SUBSTEPS              2
+#define WORLD_MAX_SUBSTEPS              20
+
+/*
+    Continuous collision: a body moving more than WORLD_CCD_FRACTION of its bounding
+    radius in a substep is swept. Its time of impact is advanced until it sinks
+    WORLD_CCD_SLOP into the other body, or for at most WORLD_CCD_ITERATIONS rounds.
+*/
+#define WORLD_CCD_FRACTION              0.5f
+#define WORLD_CCD_SLOP                  0.5f
+#define WORLD_CCD_ITERATIONS            20
+
+/* approach speeds below this do not bounce, resting contacts stay at rest */
+#define WORLD_RESTITUTION_THRESHOLD     30.0f
+#define WORLD_VELOCITY_ITERATIONS       6
+
+/*
+    Positional correction leaves WORLD_LINEAR_SLOP of overlap so resting contacts keep
+    touching, and removes WORLD_BAUMGARTE of the rest each substep instead of all of it.
+*/
+#define WORLD_LINEAR_SLOP               0.1f
+#define WORLD_BAUMGARTE                 0.5f
 
 void World_Create(World **world, Vector2 gravity);
 void World_CreateDefault(World **world);
-void World_AddBody(World *world, Body *body);
+void World_Reserve(World *world, int capacity);
+BodyHandle World_AddBody(World *world, Body *body);
+bool World_RemoveBody(World *world, BodyHandle handle);
+bool World_DestroyBody(World *world, BodyHandle handle);
+void World_SetBounds(World *world, bool enabled, Vector2 min, Vector2 max);
+int World_GetBodyIndex(World *world, BodyHandle handle);
+void World_SetBroadPhase(World *world, BroadPhaseType type);
+void World_SetThreadCount(World *world, int count);
+void World_SetParallelResolve(World *world, bool enabled);
+void World_SetVelocityIterations(World *world, int iterations);
+void World_SetContinuous(World *world, bool enabled);
+void World_SetAdaptiveSubsteps(World *world, bool enabled, int minSubsteps, int maxSubsteps);
+const char *World_SubstepReasonName(WorldSubstepReason reason);
+void World_SetNarrowPhase(World *world, WorldNarrowPhase narrowPhase);
+const char *World_NarrowPhaseName(WorldNarrowPhase narrowPhase);
+void World_SetSleeping(World *world, bool enabled);
+void World_SetChecksums(World *world, bool enabled);
+void World_SetSleepThresholds(World *world, float linearVelocity, float angularVelocity, float timeToSleep);
+void World_WakeBody(World *world, BodyHandle handle);
+void World_GetStats(World *world, WorldStats *stats);
 void World_Destroy(World **world);
 
-void World_Step(World *world, Window *window, int interations, float time);
+void World_SetFixedStep(World *world, float rate, int maxSteps);
+int World_Advance(World *world, int interations, float elapsedTime);
+void World_GetInterpolated(World *world, int index, Vector2 *position);
 
-void World_ResolveCollision(Body *b0, Body *b1, Vector2 normal);
-bool World_Collide(Body *b0, Body *b1, Vector2 *normal, float *depth);
+void World_Step(World *world, int interations, float time);
+
+bool World_Collide(BodyList *bodies, WorldNarrowPhase narrowPhase, int i0, int i1, Contact *contact);
+
+enum WorldSubstepReason
+{
+    WorldSubstep_Fixed,
+    WorldSubstep_Minimum,
+    WorldSubstep_Velocity,
+    WorldSubstep_Penetration
+};
+
+/* how polygon pairs (boxes included) and polygon against circle are tested */
+enum WorldNarrowPhase
+{
+    WorldNarrowPhase_SAT,
+    WorldNarrowPhase_GJK,
+    WorldNarrowPhase_Count
+};
+
+/*
+    Time spent in each phase of the last World_Step, in nanoseconds and summed
+    over the substeps. narrowPhaseTime covers the pair tests and the merge of the
+    thread buffers, resolveTime the impulse solver and position correction of the
+    contacts (coloring included). colorCount is the most colors a substep needed, awakeCount
+    the dynamic bodies still awake after the step, removedCount the bodies destroyed or
+    culled by the step.
+*/
+struct WorldStats
+{
+    Uint64 integrateTime;
+    Uint64 broadPhaseTime;
+    Uint64 narrowPhaseTime;
+    Uint64 resolveTime;
+    Uint64 stepTime;
+
+    int pairCount;
+    int contactCount;
+    int colorCount;
+    int awakeCount;
+
+    int fixedSteps;
+    float droppedTime;
+
+    int substepCount;
+    WorldSubstepReason substepReason;
+    float maxDepth;
+    int ccdCount;
+    int removedCount;
+};
 
 struct World
 {
     Vector2 gravity;
+    ShapeLibrary shapes;
     BodyList bodies;
+
+    BroadPhase broadPhase;
+    PairList pairs;
+
+    /*
+        Pairs are split in contiguous ranges, one per worker, each testing into its
+        own buffer. The buffers are appended in worker order, so contacts come out in
+        pair order whatever the thread count. activeThreads is how many of them got
+        a range this substep.
+    */
+    ThreadPool threads;
+    int activeThreads;
+    ContactList threadContacts[THREADPOOL_MAX_WORKERS];
+    ContactList contacts;
+
+    /*
+        Sequential impulses: every substep the contacts are prepared, warm started with
+        the impulse the same pair and feature ended the last substep with (contactCache),
+        then solved velocityIterations times before the position correction.
+    */
+    ContactCache contactCache;
+    int velocityIterations;
+
+    /*
+        Parallel resolution: contacts are greedily colored in contact order so no
+        two of a color share a dynamic body, then regrouped by color into
+        coloredContacts (colorStart[c] is where color c begins, the last group is
+        the overflow). Static bodies are never written and take no color. Each color
+        is solved across the workers, one after the other. colored tells whether this
+        substep's contacts were, batchFunction is what the workers run on them.
+    */
+    bool parallelResolve;
+    bool colored;
+    WorldContactFunction batchFunction;
+    Uint64 *bodyColors;
+    int bodyColorCapacity;
+    int *contactColors;
+    int contactColorCapacity;
+    ContactList coloredContacts;
+    int colorStart[WORLD_MAX_COLORS + 2];
+    int batchStart;
+    int batchEnd;
+
+    /*
+        Sleeping: the contacts between dynamic bodies of every substep are joined
+        into islands (union-find over islandParent). A body resting
+        below both velocity thresholds accumulates sleepTime. The linear one is checked
+        against the largest squared speed the body ended a substep with (maxSpeed), a
+        pile jittering between substeps stays awake whatever the substep count; once
+        every body of an island has rested timeToSleep the whole island sleeps. Sleeping bodies are not
+        integrated and their pairs are skipped unless the other body is awake and
+        dynamic; a contact with it wakes them, and the wake spreads one contact per
+        substep through the rest of the pile.
+    */
+    bool sleeping;
+    float sleepLinearVelocity;
+    float sleepAngularVelocity;
+    float timeToSleep;
+    int *islandParent;
+    float *islandTime;
+    float *maxSpeed;
+    int islandCapacity;
+    int islandTimeCapacity;
+    int maxSpeedCapacity;
+
+    /*
+        World_Advance banks the frame time in accumulator and spends it in steps of
+        fixedTimeStep, at most maxFixedSteps per frame. alpha is the fraction of a step
+        left over, how far rendering is between the last two steps.
+    */
+    float fixedTimeStep;
+    int maxFixedSteps;
+    float accumulator;
+    float alpha;
+
+    /*
+        With adaptiveSubsteps World_Step ignores its substep count and picks one
+        between minSubsteps and maxSubsteps from the fastest awake body and the
+        deepest contact of the previous step (lastMaxDepth over lastSubsteps). With
+        continuous collision on, speed no longer asks for substeps, CCD covers it.
+    */
+    bool adaptiveSubsteps;
+    int minSubsteps;
+    int maxSubsteps;
+    int lastSubsteps;
+    float lastMaxDepth;
+
+    /*
+        Continuous collision, run between the broad-phase and the narrow-phase. Fast
+        bodies get an AABB swept back to where the substep started, then every pair
+        of a fast body with a slow one is advanced conservatively, the slow body held
+        at its new position. ccdTime[i] is -1 for slow bodies, otherwise the earliest
+        impact found as a fraction of the substep. Fast against fast is left to the solver.
+    */
+    bool continuous;
+    float *ccdTime;
+    int ccdTimeCapacity;
+
+    /*
+        Deferred removal: World_DestroyBody only marks the body dead, World_Step drops
+        every dead body in one BodyList_Compact before its first substep and after its
+        last. With bounded set, dynamic bodies whose AABB left bounds are marked dead at
+        the end of the step. remap is the old to new index map of the compaction.
+    */
+    int deadCount;
+    bool bounded;
+    AABB bounds;
+    int *remap;
+    int remapCapacity;
+
+    /*
+        With checksums, every step folds the bits of the body positions, velocities
+        and rotations into checksum, so two runs agree on it only if every step they
+        took did.
+    */
+    bool checksums;
+    Uint64 checksum;
+
+    /*
+        SAT projects both polygons on every edge normal, GJK with EPA only walks the
+        support points and scales better with many-sided hulls. Circle pairs always
+        take the closed form.
+    */
+    WorldNarrowPhase narrowPhase;
+
+    int pairCount;
+    int contactCount;
+
+    WorldStats stats;
 };
 
 #endif
\ No newline at end of file
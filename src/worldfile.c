@@ -0,0 +1,480 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "worldfile.h"
+#include "world.h"
+#include "body.h"
+#include "shape.h"
+#include "alloc.h"
+
+/* big enough that the writer hands the kernel a few large writes instead of many small ones */
+#define WORLDFILE_WRITE_BUFFER  (1 << 20)
+
+static bool WorldFile_IsLittleEndian(void)
+{
+    Uint32 value = 1;
+    return *(Uint8 *)&value == 1;
+}
+
+/*
+    Every array of the file in order, pointing at the world's storage. The writer
+    reads the sections from there, the loader fills them after sizing the storage
+    from the header, so both always agree on the layout.
+*/
+static int WorldFile_GetSections(World *world, WorldFileHeader *header, Uint8 *colors, WorldFileSection *sections)
+{
+    ShapeLibrary *shapes = &world->shapes;
+    BodyList *bodies = &world->bodies;
+
+    Uint64 bodyLength = header->bodyLength;
+    Uint64 slotLength = header->slotLength;
+    Uint64 vertexLength = header->vertexLength;
+    int count = 0;
+
+    sections[count++] = (WorldFileSection){shapes->shapes, header->shapeLength * sizeof(Shape)};
+    sections[count++] = (WorldFileSection){shapes->vertices, vertexLength * sizeof(Vector2)};
+    sections[count++] = (WorldFileSection){shapes->normals, vertexLength * sizeof(Vector2)};
+
+    sections[count++] = (WorldFileSection){bodies->bodies, bodyLength * sizeof(Body)};
+
+    float *arrays[10] = {bodies->positionX, bodies->positionY,
+                        bodies->velocityX, bodies->velocityY,
+                        bodies->invMass, bodies->resistituion,
+                        bodies->awake, bodies->sleepTime,
+                        bodies->previousX, bodies->previousY};
+
+    for (int i = 0; i < 10; ++i)
+    {
+        sections[count++] = (WorldFileSection){arrays[i], bodyLength * sizeof(float)};
+    }
+
+    sections[count++] = (WorldFileSection){bodies->vertices, bodyLength * SHAPE_MAX_VERTICES * sizeof(Vector2)};
+    sections[count++] = (WorldFileSection){bodies->normals, bodyLength * SHAPE_MAX_VERTICES * sizeof(Vector2)};
+    sections[count++] = (WorldFileSection){bodies->centroids, bodyLength * sizeof(Vector2)};
+
+    sections[count++] = (WorldFileSection){bodies->slots, bodyLength * sizeof(int)};
+    sections[count++] = (WorldFileSection){bodies->slotIndex, slotLength * sizeof(int)};
+    sections[count++] = (WorldFileSection){bodies->slotGeneration, slotLength * sizeof(Uint32)};
+
+    sections[count++] = (WorldFileSection){colors, header->colorLength * 4ull};
+
+    return count;
+}
+
+static Uint64 WorldFile_Align(Uint64 offset)
+{
+    return (offset + WORLDFILE_ALIGNMENT - 1) & ~(Uint64)(WORLDFILE_ALIGNMENT - 1);
+}
+
+/*
+    Streams the world to path, one write per array. The simulation state is saved as
+    it is between two steps; the broad-phase, contacts and settings are not, the
+    loaded world starts with the defaults of World_Create.
+*/
+bool WorldFile_Save(World *world, const char *path, const Uint8 *colors)
+{
+    if (!WorldFile_IsLittleEndian())
+    {
+        printf("Error world files are little-endian only.\n");
+        return false;
+    }
+
+    WorldFileHeader header;
+    memset(&header, 0, sizeof(WorldFileHeader));
+
+    header.magic = WORLDFILE_MAGIC;
+    header.version = WORLDFILE_VERSION;
+    header.bodySize = sizeof(Body);
+    header.shapeSize = sizeof(Shape);
+    header.gravity[0] = world->gravity[0];
+    header.gravity[1] = world->gravity[1];
+    header.bodyLength = world->bodies.length;
+    header.slotLength = world->bodies.slotLength;
+    header.freeSlot = world->bodies.freeSlot;
+    header.shapeLength = world->shapes.length;
+    header.vertexLength = world->shapes.vertexLength;
+    header.colorLength = (colors != NULL) ? world->bodies.slotLength : 0;
+
+    /* BodyList keeps it NULL, a pointer of this process means nothing in the file */
+    for (int i = 0; i < world->bodies.length; ++i)
+    {
+        world->bodies.bodies[i].transformedVertices = NULL;
+    }
+
+    WorldFileSection sections[WORLDFILE_MAX_SECTIONS];
+    header.sectionCount = WorldFile_GetSections(world, &header, (Uint8 *)colors, sections);
+
+    Uint64 offset = WorldFile_Align(sizeof(WorldFileHeader));
+
+    for (int i = 0; i < header.sectionCount; ++i)
+    {
+        header.offsets[i] = offset;
+        header.sizes[i] = sections[i].size;
+        offset = WorldFile_Align(offset + sections[i].size);
+    }
+
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL)
+    {
+        printf("Error when opening %s for writing.\n", path);
+        return false;
+    }
+
+    setvbuf(file, NULL, _IOFBF, WORLDFILE_WRITE_BUFFER);
+
+    static const Uint8 zeros[WORLDFILE_ALIGNMENT] = {0};
+    bool written = (fwrite(&header, sizeof(WorldFileHeader), 1, file) == 1);
+    Uint64 position = sizeof(WorldFileHeader);
+
+    for (int i = 0; written && i < header.sectionCount; ++i)
+    {
+        Uint64 padding = header.offsets[i] - position;
+
+        if (padding > 0)
+        {
+            written = (fwrite(zeros, 1, padding, file) == padding);
+        }
+
+        if (written && sections[i].size > 0)
+        {
+            written = (fwrite(sections[i].data, 1, sections[i].size, file) == sections[i].size);
+        }
+
+        position = header.offsets[i] + sections[i].size;
+    }
+
+    if (fclose(file) != 0 || !written)
+    {
+        printf("Error when writing %s.\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+static bool WorldFile_Check(WorldFileHeader *header, Uint64 fileSize)
+{
+    if (header->magic != WORLDFILE_MAGIC || header->version != WORLDFILE_VERSION)
+    {
+        printf("Error not a world file of version %i.\n", WORLDFILE_VERSION);
+        return false;
+    }
+
+    if (header->bodySize != sizeof(Body) || header->shapeSize != sizeof(Shape))
+    {
+        printf("Error the world file was written by a build with another body layout.\n");
+        return false;
+    }
+
+    if (header->bodyLength < 0 || header->slotLength < header->bodyLength || header->freeSlot < -1 ||
+        header->freeSlot >= header->slotLength || header->shapeLength < 0 ||
+        header->vertexLength < 0 || header->sectionCount > WORLDFILE_MAX_SECTIONS ||
+        (header->colorLength != 0 && header->colorLength != header->slotLength))
+    {
+        printf("Error the world file header is corrupted.\n");
+        return false;
+    }
+
+    for (int i = 0; i < header->sectionCount; ++i)
+    {
+        if (header->offsets[i] > fileSize || header->sizes[i] > fileSize - header->offsets[i])
+        {
+            printf("Error the world file is truncated.\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* false for NaN too */
+static bool WorldFile_InRange(float value)
+{
+    return value >= -WORLDFILE_MAX_COORDINATE && value <= WORLDFILE_MAX_COORDINATE;
+}
+
+/*
+    Every index the loaded arrays hold, checked against the loaded lengths before
+    anything uses them: the shape vertex ranges, each body's shape, and the slots,
+    live ones mapping both ways and free ones chained once each. Positions, velocities,
+    AABBs and shape geometry must be in range, the broad-phase sizes its storage
+    from them. Counts the dead bodies so the next step compacts them.
+*/
+static bool WorldFile_Validate(World *world)
+{
+    ShapeLibrary *shapes = &world->shapes;
+    BodyList *bodies = &world->bodies;
+
+    for (int i = 0; i < shapes->length; ++i)
+    {
+        Shape *shape = &shapes->shapes[i];
+
+        if (shape->type < Box || shape->type > Polygon || 
+            shape->vertLength < 0 || shape->vertLength > SHAPE_MAX_VERTICES || 
+            shape->vertexCapacity < shape->vertLength || shape->vertexOffset < 0 || 
+            shape->vertexOffset > shapes->vertexLength - shape->vertexCapacity || 
+            !WorldFile_InRange(shape->radius) || !WorldFile_InRange(shape->boundingRadius))
+        {
+            return false;
+        }
+
+        Vector2 *vertices = &shapes->vertices[shape->vertexOffset];
+
+        for (int v = 0; v < shape->vertLength; ++v)
+        {
+            if (!WorldFile_InRange(vertices[v][0]) || !WorldFile_InRange(vertices[v][1]))
+            {
+                return false;
+            }
+        }
+    }
+
+    world->deadCount = 0;
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        Body *body = &bodies->bodies[i];
+
+        if (body->shapeId < 0 || body->shapeId >= shapes->length || 
+            body->shape != shapes->shapes[body->shapeId].type || 
+            body->vertLength != shapes->shapes[body->shapeId].vertLength)
+        {
+            return false;
+        }
+
+        float values[10] = {bodies->positionX[i], bodies->positionY[i], bodies->previousX[i], bodies->previousY[i], 
+                            bodies->velocityX[i], bodies->velocityY[i], 
+                            body->aabb[0][0], body->aabb[0][1], body->aabb[1][0], body->aabb[1][1]};
+
+        for (int v = 0; v < 10; ++v)
+        {
+            if (!WorldFile_InRange(values[v]))
+            {
+                return false;
+            }
+        }
+
+        /* read as bytes, a bool holding anything but 0 or 1 is undefined */
+        Uint8 flags[2];
+        memcpy(&flags[0], &body->isStatic, 1);
+        memcpy(&flags[1], &body->isDead, 1);
+
+        if (flags[0] > 1 || flags[1] > 1)
+        {
+            return false;
+        }
+
+        body->transformedVertices = NULL;
+        world->deadCount += flags[1];
+    }
+
+    /* 1 for a live slot, 2 for a free one, a slot seen twice is corrupted */
+    Uint8 *seen = (Uint8 *)Alloc_Malloc((bodies->slotLength > 0) ? bodies->slotLength : 1);
+
+    if (seen == NULL)
+    {
+        return false;
+    }
+
+    memset(seen, 0, bodies->slotLength);
+    bool valid = true;
+
+    for (int i = 0; valid && i < bodies->length; ++i)
+    {
+        int slot = bodies->slots[i];
+        valid = (slot >= 0 && slot < bodies->slotLength && !seen[slot] && bodies->slotIndex[slot] == i);
+
+        if (valid)
+        {
+            seen[slot] = 1;
+        }
+    }
+
+    int freeCount = 0;
+    int slot = bodies->freeSlot;
+
+    while (valid && slot != -1)
+    {
+        valid = (slot >= 0 && slot < bodies->slotLength && !seen[slot]);
+
+        if (valid)
+        {
+            seen[slot] = 2;
+            freeCount++;
+            slot = bodies->slotIndex[slot];
+        }
+    }
+
+    valid = valid && (bodies->length + freeCount == bodies->slotLength);
+    Alloc_Free(seen);
+
+    return valid;
+}
+
+/* storage for the arrays the header announces, no per-body work */
+static bool WorldFile_Allocate(World *world, WorldFileHeader *header)
+{
+    ShapeLibrary *shapes = &world->shapes;
+    int capacity = (header->slotLength > 64) ? header->slotLength : 64;
+
+    if (!BodyList_Reserve(&world->bodies, capacity))
+    {
+        return false;
+    }
+
+    if (header->shapeLength > 0)
+    {
+        shapes->shapes = (Shape *)Alloc_Malloc(header->shapeLength * sizeof(Shape));
+        shapes->capacity = header->shapeLength;
+
+        if (shapes->shapes == NULL)
+        {
+            return false;
+        }
+    }
+
+    if (header->vertexLength > 0)
+    {
+        shapes->vertices = (Vector2 *)Alloc_Malloc(header->vertexLength * sizeof(Vector2));
+        shapes->normals = (Vector2 *)Alloc_Malloc(header->vertexLength * sizeof(Vector2));
+        shapes->vertexCapacity = header->vertexLength;
+
+        if (shapes->vertices == NULL || shapes->normals == NULL)
+        {
+            return false;
+        }
+    }
+
+    shapes->length = header->shapeLength;
+    shapes->vertexLength = header->vertexLength;
+
+    return true;
+}
+
+/*
+    Maps the file and copies each section in one block into a fresh world, colors
+    (when asked for and present) into an Alloc_Malloc array the caller frees.
+    The bodies are then inserted in the default broad-phase.
+*/
+bool WorldFile_Load(World **world, const char *path, Uint8 **colors, int *colorLength)
+{
+    *world = NULL;
+
+    if (colors != NULL)
+    {
+        *colors = NULL;
+        *colorLength = 0;
+    }
+
+    int descriptor = open(path, O_RDONLY);
+
+    if (descriptor == -1)
+    {
+        printf("Error when opening %s.\n", path);
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0 || (Uint64)status.st_size < sizeof(WorldFileHeader))
+    {
+        printf("Error %s is not a world file.\n", path);
+        close(descriptor);
+        return false;
+    }
+
+    Uint64 fileSize = (Uint64)status.st_size;
+    Uint8 *mapping = (Uint8 *)mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        printf("Error when mapping %s.\n", path);
+        return false;
+    }
+
+    WorldFileHeader header;
+    memcpy(&header, mapping, sizeof(WorldFileHeader));
+
+    if (!WorldFile_IsLittleEndian() || !WorldFile_Check(&header, fileSize))
+    {
+        munmap(mapping, fileSize);
+        return false;
+    }
+
+    Vector2 gravity = {header.gravity[0], header.gravity[1]};
+    World_Create(world, gravity);
+
+    Uint8 *colorData = NULL;
+
+    if (header.colorLength > 0 && colors != NULL)
+    {
+        colorData = (Uint8 *)Alloc_Malloc(header.colorLength * 4);
+    }
+
+    WorldFileSection sections[WORLDFILE_MAX_SECTIONS];
+    bool loaded = (*world != NULL && WorldFile_Allocate(*world, &header) &&
+                    WorldFile_GetSections(*world, &header, colorData, sections) == header.sectionCount);
+
+    for (int i = 0; loaded && i < header.sectionCount; ++i)
+    {
+        loaded = (sections[i].size == header.sizes[i]);
+    }
+
+    if (!loaded)
+    {
+        printf("Error when loading %s.\n", path);
+        World_Destroy(world);
+        *world = NULL;
+        Alloc_Free(colorData);
+        munmap(mapping, fileSize);
+        return false;
+    }
+
+    for (int i = 0; i < header.sectionCount; ++i)
+    {
+        if (sections[i].data != NULL && sections[i].size > 0)
+        {
+            memcpy(sections[i].data, mapping + header.offsets[i], sections[i].size);
+        }
+    }
+
+    munmap(mapping, fileSize);
+
+    BodyList *bodies = &(*world)->bodies;
+    bodies->length = header.bodyLength;
+    bodies->slotLength = header.slotLength;
+    bodies->freeSlot = header.freeSlot;
+
+    if (!WorldFile_Validate(*world))
+    {
+        printf("Error the world file %s is corrupted.\n", path);
+
+        /* the bodies were never acquired, their shape ids may be what is corrupted */
+        bodies->length = 0;
+        World_Destroy(world);
+        *world = NULL;
+        Alloc_Free(colorData);
+        return false;
+    }
+
+    BroadPhase_Reserve(&(*world)->broadPhase, bodies->capacity);
+
+    for (int i = 0; i < bodies->length; ++i)
+    {
+        BroadPhase_Insert(&(*world)->broadPhase, bodies, i);
+    }
+
+    if (colorData != NULL)
+    {
+        *colors = colorData;
+        *colorLength = header.colorLength;
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef _WORLDFILE_H_
+#define _WORLDFILE_H_
+
+#include "types.h"
+#include <stdbool.h>
+
+typedef struct World                    World;
+
+typedef struct WorldFileHeader          WorldFileHeader;
+typedef struct WorldFileSection         WorldFileSection;
+
+#define WORLDFILE_MAGIC         0x454e4950u     /* "PINE" read as little-endian */
+#define WORLDFILE_VERSION       1
+#define WORLDFILE_ALIGNMENT     64
+#define WORLDFILE_MAX_SECTIONS  24
+
+/* loaded coordinates past this (or not finite) are rejected, the grid cell spans stay in an int */
+#define WORLDFILE_MAX_COORDINATE 1e6f
+
+/* colors are optional, 4 bytes (RGBA) per body handle slot */
+bool WorldFile_Save(World *world, const char *path, const Uint8 *colors);
+bool WorldFile_Load(World **world, const char *path, Uint8 **colors, int *colorLength);
+
+/*
+    Binary snapshot of a world: the header, then every array of the shape library
+    and of the BodyList written as is, each section starting on a WORLDFILE_ALIGNMENT
+    boundary at offsets[i]. The sections always come in the same order (see
+    WorldFile_GetSections) and an empty one has a size of 0. Everything is little-endian
+    and in the in-memory layout of the machine that wrote it; bodySize and shapeSize
+    reject files from a build where Body or Shape differ.
+*/
+struct WorldFileHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 bodySize;
+    Uint32 shapeSize;
+
+    float gravity[2];
+
+    int bodyLength;
+    int slotLength;
+    int freeSlot;
+    int shapeLength;
+    int vertexLength;
+    int colorLength;
+
+    int sectionCount;
+    int padding;
+
+    Uint64 offsets[WORLDFILE_MAX_SECTIONS];
+    Uint64 sizes[WORLDFILE_MAX_SECTIONS];
+};
+
+struct WorldFileSection
+{
+    void *data;
+    Uint64 size;
+};
+
+#endif